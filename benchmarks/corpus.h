@@ -0,0 +1,302 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+
+// Generating JSON documents for the benchmarks. The output depends only on the
+// options (including the seed), so the same workload can be created again on
+// any machine - we are using mt19937_64 directly and not the std distributions,
+// since these are not the same in all the standard libraries.
+namespace json::bench
+{
+
+enum class shape_t {
+    random,             // objects and arrays, controlled by the options
+    message_header,     // the message from examples/read
+    foo,                // the structs from examples/structs
+    bar,
+    baz
+};
+
+struct corpus_options
+{
+    std::uint64_t seed = 1;
+    int depth = 4;                  // max nesting of objects and arrays
+    std::size_t width = 8;          // max members in an object
+    std::size_t array_min = 0;      // number of items in arrays
+    std::size_t array_max = 8;
+    std::size_t string_min = 4;     // length of strings (and keys)
+    std::size_t string_max = 24;
+    double escape_ratio = 0.02;     // part of the string chars that are escaped
+    double unicode_ratio = 0.01;    // part of the string chars that are not ASCII
+    double number_ratio = 0.4;      // part of the scalars that are numbers (the rest are strings, booleans and nulls)
+    double real_ratio = 0.3;        // part of the numbers that are real
+    shape_t shape = shape_t::random;
+};
+
+class corpus_generator
+{
+public:
+    explicit corpus_generator(const corpus_options& opts) : options{opts}, rng{opts.seed}
+    {
+    }
+
+    // a single record of the shape, as compact JSON
+    std::string record()
+    {
+        std::string out;
+        add_record(out);
+        return out;
+    }
+
+    // a document of about size bytes: {"records":[record, ...]}
+    std::string document(std::size_t size)
+    {
+        std::string out{"{\"records\":["};
+        do {
+            if (out.back() != '[') {
+                out.push_back(',');
+            }
+            add_record(out);
+        } while (out.size() + 2 < size);
+        out += "]}";
+        return out;
+    }
+
+    // records as JSON lines
+    std::string ndjson(std::size_t count)
+    {
+        std::string out;
+        for (std::size_t i = 0; i < count; ++i) {
+            add_record(out);
+            out.push_back('\n');
+        }
+        return out;
+    }
+
+private:
+    void add_record(std::string& out)
+    {
+        switch (options.shape) {
+        case shape_t::random:
+            add_object(out, options.depth);
+            break;
+        case shape_t::message_header:
+            add_message_header(out);
+            break;
+        case shape_t::foo:
+            add_foo(out);
+            break;
+        case shape_t::bar:
+            add_bar(out);
+            break;
+        case shape_t::baz:
+            out += "{\"foo\":";
+            add_foo(out);
+            out += ",\"baz\":";
+            add_bar(out);
+            out.push_back('}');
+            break;
+        }
+    }
+
+    void add_message_header(std::string& out)
+    {
+        out += "{\"title\":{\"solution_type\":";
+        add_string(out);
+        out += ",\"solution_sub_type\":";
+        add_string(out);
+        out += ",\"message_type\":";
+        add_string(out);
+        out += ",\"uuid\":\"";
+        static constexpr char hex[] = "0123456789abcdef";
+        for (int i = 0; i < 36; ++i) {
+            out.push_back(i == 8 || i == 13 || i == 18 || i == 23 ? '-' : hex[below(16)]);
+        }
+        out += "\",\"reply_type\":[";
+        const auto count{between(options.array_min, options.array_max)};
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            add_string(out);
+        }
+        out += "]}}";
+    }
+
+    void add_foo(std::string& out)
+    {
+        out += "{\"A\":";
+        out += std::to_string(int32());
+        out += ",\"B\":";
+        out += std::to_string(int32());
+        out += ",\"C\":";
+        out += std::to_string(below(32768));
+        out += ",\"S\":";
+        add_string(out);
+        out.push_back('}');
+    }
+
+    void add_bar(std::string& out)
+    {
+        out += "{\"int values\":[";
+        auto count{between(options.array_min, options.array_max)};
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            out += std::to_string(int32());
+        }
+        out += "],\"double values\":[";
+        count = between(options.array_min, options.array_max);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            add_real(out);
+        }
+        out += "]}";
+    }
+
+    void add_value(std::string& out, int depth)
+    {
+        // at the last level we only have scalars
+        const auto pick{depth > 0 ? below(8) : 7};
+        if (pick == 0) {
+            add_object(out, depth - 1);
+        } else if (pick == 1) {
+            add_array(out, depth - 1);
+        } else {
+            add_scalar(out);
+        }
+    }
+
+    void add_object(std::string& out, int depth)
+    {
+        out.push_back('{');
+        const auto count{between(1, options.width)};
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            // the keys are simple, as they are in most messages
+            out.push_back('"');
+            const auto size{between(options.string_min, options.string_max)};
+            for (std::size_t c = 0; c < size; ++c) {
+                out.push_back(static_cast<char>('a' + below(26)));
+            }
+            out += "\":";
+            add_value(out, depth);
+        }
+        out.push_back('}');
+    }
+
+    void add_array(std::string& out, int depth)
+    {
+        out.push_back('[');
+        const auto count{between(options.array_min, options.array_max)};
+        for (std::size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                out.push_back(',');
+            }
+            add_value(out, depth);
+        }
+        out.push_back(']');
+    }
+
+    void add_scalar(std::string& out)
+    {
+        if (chance(options.number_ratio)) {
+            if (chance(options.real_ratio)) {
+                add_real(out);
+            } else {
+                out += std::to_string(integer());
+            }
+            return;
+        }
+        switch (below(8)) {
+        case 0:
+            out += "null";
+            break;
+        case 1:
+            out += below(2) ? "true" : "false";
+            break;
+        default:
+            add_string(out);
+            break;
+        }
+    }
+
+    void add_string(std::string& out)
+    {
+        static constexpr std::string_view escapes[] = {
+            "\\\"", "\\\\", "\\n", "\\t", "\\r", "\\/", "\\u00e9", "\\ud83d\\ude00"
+        };
+        static constexpr std::string_view unicode[] = {
+            "\xc3\xa9", "\xc3\xbc", "\xe2\x82\xac", "\xe4\xb8\xad", "\xf0\x9f\x98\x80"
+        };
+        out.push_back('"');
+        const auto size{between(options.string_min, options.string_max)};
+        for (std::size_t i = 0; i < size; ++i) {
+            if (chance(options.escape_ratio)) {
+                out += escapes[below(std::size(escapes))];
+            } else if (chance(options.unicode_ratio)) {
+                out += unicode[below(std::size(unicode))];
+            } else {
+                // printable ASCII, without the chars that must be escaped
+                const auto c{static_cast<char>(' ' + below(95))};
+                out.push_back(c == '"' || c == '\\' ? 'x' : c);
+            }
+        }
+        out.push_back('"');
+    }
+
+    void add_real(std::string& out)
+    {
+        // a few digits after the point, and sometimes an exponent
+        out += std::to_string(integer());
+        out.push_back('.');
+        out += std::to_string(below(1000000));
+        if (below(8) == 0) {
+            out.push_back('e');
+            out += std::to_string(static_cast<int>(below(40)) - 20);
+        }
+    }
+
+    // mostly small numbers, as they are in real messages
+    std::int64_t integer()
+    {
+        const auto value{static_cast<std::int64_t>(below(4) == 0 ? rng() >> 1 : below(100000))};
+        return below(4) == 0 ? -value : value;
+    }
+
+    // for the members of the example structs that are int
+    std::int64_t int32()
+    {
+        const auto value{static_cast<std::int64_t>(below(std::size_t{1} << 31))};
+        return below(2) == 0 ? -value : value;
+    }
+
+    std::size_t below(std::size_t n)
+    {
+        return static_cast<std::size_t>(rng() % n);
+    }
+
+    std::size_t between(std::size_t low, std::size_t high)
+    {
+        return high <= low ? low : low + below(high - low + 1);
+    }
+
+    bool chance(double ratio)
+    {
+        return static_cast<double>(rng() >> 11) * 0x1.0p-53 < ratio;
+    }
+
+private:
+    corpus_options options;
+    std::mt19937_64 rng;
+};
+
+}   // end of namespace json::bench
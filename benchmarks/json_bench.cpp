@@ -0,0 +1,458 @@
+// Benchmarks for the main paths of the library - reading the input, extracting
+// values from it, building messages and writing them. Each benchmark is running
+// on small (1KB), medium (64KB) and large (50MB) documents, and reports the
+// throughput (bytes_per_second) and the time for each operation.
+// Build with -DCMAKE_BUILD_TYPE=Release, otherwise the numbers are meaningless.
+// When building with -DJSON_PARSER_ALLOC_STATS=ON the memory allocations for
+// each operation are reported as well (allocs, alloc_bytes and peak_bytes).
+// Run with --perf_counters to report the CPU counters as well (cycles and
+// instructions per byte, branch, L1 and LLC misses per iteration) - this is
+// only on Linux, and when perf_event_open is allowed.
+// Run with --benchmark_filter to select a subset, for example:
+//  ./json_bench --benchmark_filter=parse
+#include "json_istream.h"
+#include "json_ostream.h"
+#include "json_utils.h"
+#include "json_parser.h"
+#include "corpus.h"
+#include "perf_counters.h"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct header
+{
+    std::string solution_type;
+    std::string solution_sub_type;
+    std::string message_type;
+    std::string uuid;
+    std::vector<std::string> reply_type;
+};
+
+struct record
+{
+    int id = 0;
+    double value = 0;
+    std::string name;
+    std::vector<int> samples;
+};
+
+}   // end of local namespace
+
+BOOST_FUSION_ADAPT_STRUCT(record, (int, id)(double, value)(std::string, name)(std::vector<int>, samples));
+JSON_LABELS(record, "id", "value", "name", "samples");
+
+namespace
+{
+
+auto operator ^ (json::ostream& os, const record& r) -> json::ostream& {
+    return json::util::serialized(os, r);
+}
+
+auto operator ^ (json::istream& is, record& r) -> json::istream& {
+    return json::util::deserialized(is, r);
+}
+
+auto operator ^ (json::ostream& os, const header& h) -> json::ostream& {
+    using namespace json::literals;
+    os ^ "solution_type"_n ^ h.solution_type ^ "solution_sub_type"_n ^ h.solution_sub_type
+       ^ "message_type"_n ^ h.message_type ^ "uuid"_n ^ h.uuid;
+    auto replies{os ^ "reply_type"_s};
+    replies ^ h.reply_type ^ json::_end;
+    return os;
+}
+
+constexpr std::int64_t small_size = 1024;
+constexpr std::int64_t medium_size = 64 * 1024;
+constexpr std::int64_t large_size = 50 * 1024 * 1024;
+
+header make_header(int n)
+{
+    return header{"routing", "orders", "order_update", "4c6e2b70-2f6b-4c43-8d5e-" + std::to_string(100000000000 + n),
+                  {"ack", "reject"}};
+}
+
+record make_record(int n)
+{
+    return record{n, n * 1.25, "item \"" + std::to_string(n) + "\"\tname", {n, n + 1, n * 2, n * 3}};
+}
+
+// messages of {"title": header, "records": [record, ...]} - the
+// records are added until the message is about the given size
+std::vector<record> make_records(std::int64_t size)
+{
+    // each record is about 100 bytes
+    const auto count{std::max<std::int64_t>(size / 100, 1)};
+    std::vector<record> records;
+    records.reserve(static_cast<std::size_t>(count));
+    for (std::int64_t i = 0; i < count; ++i) {
+        records.push_back(make_record(static_cast<int>(i)));
+    }
+    return records;
+}
+
+void build(json::ostream& root, const std::vector<record>& records)
+{
+    using namespace json::literals;
+    auto title{root ^ "title"_s};
+    title ^ make_header(1) ^ json::_end;
+    auto list{root ^ "records"_s};
+    list ^ records ^ json::_end;
+}
+
+// the wide ostream cannot build nested messages, so the wide
+// message is a copy of the narrow one with the text converted
+boost::property_tree::wptree widen_tree(const boost::property_tree::ptree& from)
+{
+    boost::property_tree::wptree to{json::widen_str(from.data())};
+    for (const auto& child : from) {
+        to.push_back(std::make_pair(json::widen_str(child.first), widen_tree(child.second)));
+    }
+    return to;
+}
+
+std::string make_document(std::int64_t size)
+{
+    json::output_stream out;
+    auto root{out ^ json::open};
+    build(root, make_records(size));
+    return json::write(root);
+}
+
+// the documents are created once for each size
+const std::string& document(std::int64_t size)
+{
+    static std::string documents[3];
+    auto& doc{documents[size == small_size ? 0 : (size == medium_size ? 1 : 2)]};
+    if (doc.empty()) {
+        doc = make_document(size);
+    }
+    return doc;
+}
+
+void set_bytes(benchmark::State& state, std::size_t size)
+{
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) * static_cast<std::int64_t>(size));
+    state.counters["doc_bytes"] = static_cast<double>(size);
+}
+
+// run the operation once more out of the timing, and report its allocations
+template<typename Op>
+void count_allocations(benchmark::State& state, Op&& op)
+{
+    if constexpr (json::alloc_stats_enabled) {
+        json::alloc_scope scope;
+        op();
+        const auto stats{scope.stats()};
+        state.counters["allocs"] = static_cast<double>(stats.allocations);
+        state.counters["alloc_bytes"] = static_cast<double>(stats.bytes);
+        state.counters["peak_bytes"] = static_cast<double>(stats.peak_bytes);
+    }
+}
+
+bool perf_counters_enabled = false;
+
+// the CPU counters of the benchmark loop - create it just before the loop
+class loop_counters
+{
+public:
+    loop_counters()
+    {
+        if (perf_counters_enabled) {
+            counters.emplace();
+            counters->start();
+        }
+    }
+
+    void report(benchmark::State& state, std::size_t bytes)
+    {
+        using json::bench::counter_t;
+        if (!counters || !counters->available()) {
+            return;
+        }
+        const auto counts{counters->stop()};
+        if (state.iterations() == 0) {
+            return;
+        }
+        const auto iterations{static_cast<double>(state.iterations())};
+        for (const auto c : {counter_t::cycles, counter_t::instructions}) {
+            if (counts.has(c) && bytes > 0) {
+                state.counters[std::string{json::bench::name(c)} + "_per_byte"] = counts[c] / (iterations * static_cast<double>(bytes));
+            }
+        }
+        for (const auto c : {counter_t::branch_misses, counter_t::l1d_misses, counter_t::llc_misses}) {
+            if (counts.has(c)) {
+                state.counters[json::bench::name(c)] = counts[c] / iterations;
+            }
+        }
+    }
+
+private:
+    std::optional<json::bench::perf_counters> counters;
+};
+
+template<typename Root>
+void parse(benchmark::State& state)
+{
+    const auto& doc{document(state.range(0))};
+    Root root;
+    count_allocations(state, [&] () { root.open(doc); });
+    loop_counters counters;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(root.open(doc));
+    }
+    counters.report(state, doc.size());
+    set_bytes(state, doc.size());
+}
+
+void parse_narrow(benchmark::State& state)
+{
+    parse<json::istream_root>(state);
+}
+
+// this include the conversion of the input from UTF-8
+void parse_wide(benchmark::State& state)
+{
+    parse<json::wistream_root>(state);
+}
+
+// only the ids of the records and the uuid are added to the tree
+void parse_projected(benchmark::State& state)
+{
+    const auto& doc{document(state.range(0))};
+    const json::projection fields{"title.uuid", "records[*].id"};
+    json::istream_root root;
+    count_allocations(state, [&] () { root.open(doc, fields); });
+    loop_counters counters;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(root.open(doc, fields));
+    }
+    counters.report(state, doc.size());
+    set_bytes(state, doc.size());
+}
+
+// the input from the corpus generator (the same input as json_corpus
+// creates with the default options)
+void parse_corpus(benchmark::State& state)
+{
+    json::bench::corpus_generator generator{json::bench::corpus_options{}};
+    const auto doc{generator.document(static_cast<std::size_t>(state.range(0)))};
+    json::istream_root root;
+    count_allocations(state, [&] () { root.open(doc); });
+    loop_counters counters;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(root.open(doc));
+    }
+    counters.report(state, doc.size());
+    set_bytes(state, doc.size());
+}
+
+// only check the input, without reading it
+void validate(benchmark::State& state)
+{
+    const auto& doc{document(state.range(0))};
+    loop_counters counters;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(json::validate(doc));
+    }
+    counters.report(state, doc.size());
+    set_bytes(state, doc.size());
+}
+
+template<typename Root>
+void extract_scalars(benchmark::State& state)
+{
+    using namespace json::literals;
+    const auto& doc{document(state.range(0))};
+    Root root;
+    root.open(doc);
+    auto js{root ^ json::_root};
+    // the records are the last member of the message - we are not using
+    // get_child since it is not supported for the wide version
+    auto& records{const_cast<typename Root::proptree_type&>(js.entries().back().second)};
+    const auto read{[&] () {
+        for (auto& entry : records) {
+            typename Root::stream_type rec{entry.second, js.source_document()};
+            int id = 0;
+            double value = 0;
+            rec ^ "id"_n ^ id ^ "value"_n ^ value;
+            benchmark::DoNotOptimize(id);
+            benchmark::DoNotOptimize(value);
+        }
+    }};
+    count_allocations(state, read);
+    loop_counters counters;
+    for (auto _ : state) {
+        read();
+    }
+    counters.report(state, doc.size());
+    set_bytes(state, doc.size());
+    state.counters["values"] = benchmark::Counter(static_cast<double>(2 * records.size()),
+                                                  benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void extract_scalars_narrow(benchmark::State& state)
+{
+    extract_scalars<json::istream_root>(state);
+}
+
+void extract_scalars_wide(benchmark::State& state)
+{
+    extract_scalars<json::wistream_root>(state);
+}
+
+void extract_header(benchmark::State& state)
+{
+    using namespace json::literals;
+    const auto& doc{document(state.range(0))};
+    json::istream_root root;
+    root.open(doc);
+    auto js{root ^ json::_root};
+    auto title{js.get_child("title"_n)};
+    const auto read{[&] () {
+        header h;
+        title ^ "solution_type"_n ^ h.solution_type ^ "solution_sub_type"_n ^ h.solution_sub_type
+              ^ "message_type"_n ^ h.message_type ^ "uuid"_n ^ h.uuid;
+        auto replies{title.get_child("reply_type"_n)};
+        replies ^ json::start_arr ^ h.reply_type ^ json::end_arr;
+        return h;
+    }};
+    count_allocations(state, read);
+    loop_counters counters;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(read());
+    }
+    counters.report(state, doc.size());
+    set_bytes(state, doc.size());
+}
+
+// read all the records with json::util::deserialized
+void deserialize(benchmark::State& state)
+{
+    using namespace json::literals;
+    const auto& doc{document(state.range(0))};
+    json::istream_root root;
+    root.open(doc);
+    auto js{root ^ json::_root};
+    auto list{js.get_child("records"_n)};
+    std::vector<record> records;
+    const auto read{[&] () {
+        records.clear();
+        list ^ records;
+    }};
+    count_allocations(state, read);
+    loop_counters counters;
+    for (auto _ : state) {
+        read();
+        benchmark::DoNotOptimize(records.data());
+    }
+    counters.report(state, doc.size());
+    set_bytes(state, doc.size());
+}
+
+// build the message with json::util::serialized, without writing it
+void serialize(benchmark::State& state)
+{
+    const auto records{make_records(state.range(0))};
+    const auto create{[&] () {
+        json::output_stream out;
+        auto root{out ^ json::open};
+        build(root, records);
+        benchmark::DoNotOptimize(root.entries());
+    }};
+    count_allocations(state, create);
+    loop_counters counters;
+    for (auto _ : state) {
+        create();
+    }
+    const auto size{document(state.range(0)).size()};
+    counters.report(state, size);
+    set_bytes(state, size);
+}
+
+void write_narrow(benchmark::State& state)
+{
+    json::output_stream out;
+    auto root{out ^ json::open};
+    build(root, make_records(state.range(0)));
+    std::string result;
+    count_allocations(state, [&] () { json::write(root); });
+    loop_counters counters;
+    for (auto _ : state) {
+        result.clear();
+        json::write(root, result);
+        benchmark::DoNotOptimize(result.data());
+    }
+    counters.report(state, result.size());
+    set_bytes(state, result.size());
+}
+
+void write_wide(benchmark::State& state)
+{
+    json::output_stream out;
+    auto narrow{out ^ json::open};
+    build(narrow, make_records(state.range(0)));
+    auto tree{widen_tree(narrow.entries())};
+    json::wostream root{tree};
+    std::wstring result;
+    count_allocations(state, [&] () { json::wwrite(root); });
+    loop_counters counters;
+    for (auto _ : state) {
+        result.clear();
+        json::wwrite(root, result);
+        benchmark::DoNotOptimize(result.data());
+    }
+    counters.report(state, result.size() * sizeof(wchar_t));
+    set_bytes(state, result.size() * sizeof(wchar_t));
+}
+
+void sizes(benchmark::internal::Benchmark* b)
+{
+    b->Arg(small_size)->Arg(medium_size)->Arg(large_size)->Unit(benchmark::kMicrosecond);
+}
+
+}   // end of local namespace
+
+BENCHMARK(parse_narrow)->Apply(sizes);
+BENCHMARK(parse_wide)->Apply(sizes);
+BENCHMARK(parse_projected)->Apply(sizes);
+BENCHMARK(parse_corpus)->Apply(sizes);
+BENCHMARK(validate)->Apply(sizes);
+BENCHMARK(extract_scalars_narrow)->Apply(sizes);
+BENCHMARK(extract_scalars_wide)->Apply(sizes);
+BENCHMARK(extract_header)->Arg(small_size)->Unit(benchmark::kNanosecond);
+BENCHMARK(deserialize)->Apply(sizes);
+BENCHMARK(serialize)->Apply(sizes);
+BENCHMARK(write_narrow)->Apply(sizes);
+BENCHMARK(write_wide)->Apply(sizes);
+
+int main(int argc, char** argv)
+{
+    // our own flag, we are removing it before passing the rest to the library
+    int count = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string{argv[i]} == "--perf_counters") {
+            perf_counters_enabled = true;
+        } else {
+            argv[count++] = argv[i];
+        }
+    }
+    argc = count;
+    if (perf_counters_enabled && !json::bench::perf_counters{}.available()) {
+        std::cerr << "the CPU counters are not available (perf_event_open failed), running without them\n";
+        perf_counters_enabled = false;
+    }
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
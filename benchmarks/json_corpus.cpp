@@ -0,0 +1,118 @@
+// Create JSON input for the benchmarks - the same options always create
+// the same output. For example:
+//  ./json_corpus --shape=random --depth=6 --size=1000000 --seed=7 > doc.json
+//  ./json_corpus --shape=message_header --records=10000 > headers.ndjson
+// Run with --help for all the options
+#include "corpus.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+
+namespace
+{
+
+void usage(const char* name)
+{
+    std::cerr << "usage: " << name << " [--option=value ...]\n"
+              << "  --shape=random|message_header|foo|bar|baz  the records type (default random)\n"
+              << "  --size=<bytes>        write a single document of about this size (default 65536)\n"
+              << "  --records=<count>     write this number of records as NDJSON instead\n"
+              << "  --seed=<n>            the same seed create the same output (default 1)\n"
+              << "  --depth=<n>           max nesting (default 4)\n"
+              << "  --width=<n>           max members in an object (default 8)\n"
+              << "  --array-min=<n> --array-max=<n>    number of items in arrays (default 0-8)\n"
+              << "  --string-min=<n> --string-max=<n>  length of strings (default 4-24)\n"
+              << "  --escapes=<ratio>     part of the string chars that are escaped (default 0.02)\n"
+              << "  --unicode=<ratio>     part of the string chars that are not ASCII (default 0.01)\n"
+              << "  --numbers=<ratio>     part of the values that are numbers (default 0.4)\n"
+              << "  --reals=<ratio>       part of the numbers that are real (default 0.3)\n"
+              << "  --output=<file>       write to the file and not to stdout\n";
+}
+
+bool read_shape(const std::string& value, json::bench::shape_t& shape)
+{
+    using json::bench::shape_t;
+    static const std::map<std::string, shape_t> shapes = {
+        {"random", shape_t::random},
+        {"message_header", shape_t::message_header},
+        {"foo", shape_t::foo},
+        {"bar", shape_t::bar},
+        {"baz", shape_t::baz}
+    };
+    const auto i{shapes.find(value)};
+    if (i == shapes.end()) {
+        return false;
+    }
+    shape = i->second;
+    return true;
+}
+
+}   // end of local namespace
+
+int main(int argc, char** argv)
+{
+    json::bench::corpus_options options;
+    std::size_t size = 64 * 1024;
+    std::size_t records = 0;
+    std::string output;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg{argv[i]};
+            const auto eq{arg.find('=')};
+            const auto name{arg.substr(0, eq)};
+            const auto value{eq == std::string::npos ? std::string{} : arg.substr(eq + 1)};
+            if (name == "--shape" && read_shape(value, options.shape)) {
+                continue;
+            } else if (name == "--size") {
+                size = std::stoul(value);
+            } else if (name == "--records") {
+                records = std::stoul(value);
+            } else if (name == "--seed") {
+                options.seed = std::stoull(value);
+            } else if (name == "--depth") {
+                options.depth = std::stoi(value);
+            } else if (name == "--width") {
+                options.width = std::stoul(value);
+            } else if (name == "--array-min") {
+                options.array_min = std::stoul(value);
+            } else if (name == "--array-max") {
+                options.array_max = std::stoul(value);
+            } else if (name == "--string-min") {
+                options.string_min = std::stoul(value);
+            } else if (name == "--string-max") {
+                options.string_max = std::stoul(value);
+            } else if (name == "--escapes") {
+                options.escape_ratio = std::stod(value);
+            } else if (name == "--unicode") {
+                options.unicode_ratio = std::stod(value);
+            } else if (name == "--numbers") {
+                options.number_ratio = std::stod(value);
+            } else if (name == "--reals") {
+                options.real_ratio = std::stod(value);
+            } else if (name == "--output") {
+                output = value;
+            } else {
+                usage(argv[0]);
+                return name == "--help" ? 0 : -1;
+            }
+        }
+    } catch (const std::exception&) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    json::bench::corpus_generator generator{options};
+    const auto text{records > 0 ? generator.ndjson(records) : generator.document(size) + "\n"};
+    if (output.empty()) {
+        std::cout << text;
+        return std::cout ? 0 : -2;
+    }
+    std::ofstream file{output, std::ios::binary};
+    if (!(file << text)) {
+        std::cerr << "failed to write to " << output << "\n";
+        return -2;
+    }
+    return 0;
+}
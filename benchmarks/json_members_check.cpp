@@ -0,0 +1,286 @@
+// Check that the structs whose members are added directly to the tree (see
+// json::util::serialized and build_entry) are written exactly as they are
+// written member by member with a child stream for each of them, and that
+// a copy of the tree is written the same. For example:
+//  ./json_members_check --count=10000 --seed=7
+// Return 0 when all the outputs are the same, otherwise print the first
+// difference and return 1
+#include "json_ostream.h"
+#include "json_utils.h"
+#include "json_parser.h"
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct point
+{
+    int x = 0;
+    double y = 0;
+};
+
+struct item
+{
+    std::string name;
+    std::optional<int> count;
+    std::optional<std::string> note;
+    std::vector<int> values;
+    std::optional<std::vector<double>> weights;
+    bool flag = false;
+    point at;
+    std::vector<point> path;
+    std::list<std::string> tags;
+};
+
+// members that are written before and after the members of the item,
+// the name is replaced by the name of the item
+struct tagged
+{
+    std::string kind;
+    item body;
+    long seq = 0;
+};
+
+struct group
+{
+    item first;
+    std::vector<item> rest;
+    std::vector<unsigned int> ids;
+    point origin;
+};
+
+}   // end of local namespace
+
+BOOST_FUSION_ADAPT_STRUCT(point, (int, x)(double, y));
+JSON_LABELS(point, "x", "y");
+BOOST_FUSION_ADAPT_STRUCT(item, (std::string, name)(std::optional<int>, count)(std::optional<std::string>, note)
+        (std::vector<int>, values)(std::optional<std::vector<double>>, weights)(bool, flag)(point, at)
+        (std::vector<point>, path)(std::list<std::string>, tags));
+JSON_LABELS(item, "name", "count", "note", "values", "weights", "flag", "at", "path", "tags");
+BOOST_FUSION_ADAPT_STRUCT(group, (item, first)(std::vector<item>, rest)(std::vector<unsigned int>, ids)(point, origin));
+JSON_LABELS(group, "first", "rest", "ids", "origin");
+
+namespace
+{
+
+auto operator ^ (json::ostream& os, const point& p) -> json::ostream& {
+    return json::util::serialized(os, p);
+}
+
+auto operator ^ (json::ostream& os, const item& i) -> json::ostream& {
+    return json::util::serialized(os, i);
+}
+
+auto operator ^ (json::ostream& os, const tagged& t) -> json::ostream& {
+    using namespace json::literals;
+    os ^ "name"_n ^ t.kind;
+    json::util::serialized(os, t.body);
+    return os ^ "seq"_n ^ t.seq;
+}
+
+auto operator ^ (json::ostream& os, const group& g) -> json::ostream& {
+    return json::util::build_entry(os, g);
+}
+
+class generator
+{
+public:
+    explicit generator(unsigned long long seed) : engine{seed}
+    {
+    }
+
+    point make_point()
+    {
+        return point{static_cast<int>(between(0, 2000000)) - 1000000, real()};
+    }
+
+    item make_item()
+    {
+        item i;
+        i.name = text();
+        if (chance()) {
+            i.count = static_cast<int>(between(0, 100000));
+        }
+        if (chance()) {
+            i.note = text();
+        }
+        for (auto n = between(0, 6); n > 0; --n) {
+            i.values.push_back(static_cast<int>(between(0, 20000)) - 10000);
+        }
+        if (chance()) {
+            i.weights.emplace();
+            for (auto n = between(0, 4); n > 0; --n) {
+                i.weights->push_back(real());
+            }
+        }
+        i.flag = chance();
+        i.at = make_point();
+        for (auto n = between(0, 3); n > 0; --n) {
+            i.path.push_back(make_point());
+        }
+        for (auto n = between(0, 3); n > 0; --n) {
+            i.tags.push_back(text());
+        }
+        return i;
+    }
+
+    tagged make_tagged()
+    {
+        return tagged{text(), make_item(), static_cast<long>(between(0, 1000000))};
+    }
+
+    group make_group()
+    {
+        group g;
+        g.first = make_item();
+        for (auto n = between(0, 3); n > 0; --n) {
+            g.rest.push_back(make_item());
+        }
+        for (auto n = between(0, 5); n > 0; --n) {
+            g.ids.push_back(static_cast<unsigned int>(between(0, 1000000)));
+        }
+        g.origin = make_point();
+        return g;
+    }
+
+private:
+    // strings with the chars that are escaped, quotes and non ASCII
+    std::string text()
+    {
+        static const std::string special[] = {
+            "\"", "\\", "/", "\b", "\f", "\n", "\r", "\t", "\x01", "\xc3\xa9", "\xe2\x82\xac", "\\u0041"
+        };
+        std::string s;
+        for (auto n = between(0, 12); n > 0; --n) {
+            if (between(0, 5) == 0) {
+                s += special[between(0, std::size(special) - 1)];
+            } else {
+                s += static_cast<char>('a' + between(0, 25));
+            }
+        }
+        return s;
+    }
+
+    double real()
+    {
+        return std::uniform_real_distribution<double>{-1e6, 1e6}(engine);
+    }
+
+    std::size_t between(std::size_t low, std::size_t high)
+    {
+        return std::uniform_int_distribution<std::size_t>{low, high}(engine);
+    }
+
+    bool chance()
+    {
+        return between(0, 1) == 1;
+    }
+
+private:
+    std::mt19937_64 engine;
+};
+
+// the same as serialized and build_entry, with a child stream for each member
+auto by_member(json::ostream& os, const item& i) -> json::ostream& {
+    using json::util::private_::insert_to;
+    insert_to(os, i.name, "name");
+    insert_to(os, i.count, "count");
+    insert_to(os, i.note, "note");
+    insert_to(os, i.values, "values");
+    insert_to(os, i.weights, "weights");
+    insert_to(os, i.flag, "flag");
+    insert_to(os, i.at, "at");
+    insert_to(os, i.path, "path");
+    return insert_to(os, i.tags, "tags");
+}
+
+auto by_member(json::ostream& os, const tagged& t) -> json::ostream& {
+    using namespace json::literals;
+    os ^ "name"_n ^ t.kind;
+    by_member(os, t.body);
+    return os ^ "seq"_n ^ t.seq;
+}
+
+auto by_member(json::ostream& os, const group& g) -> json::ostream& {
+    const char* const labels[] = {"first", "rest", "ids", "origin"};
+    std::size_t at = 0;
+    boost::fusion::for_each(g, [&](const auto& member) {
+            auto rr = os ^ json::_start(labels[at++]);
+            rr ^ member ^ json::_end;
+        }
+    );
+    return os;
+}
+
+template<typename T>
+std::string direct(const T& value, bool copied)
+{
+    json::output_stream out;
+    auto js{out ^ json::open};
+    js ^ value;
+    if (!copied) {
+        return out.str();
+    }
+    // all the values are in the tree, so a copy of it has them as well
+    auto tree{out.tree_root};
+    json::ostream copy{tree};
+    return json::write(copy);
+}
+
+template<typename T>
+std::string per_member(const T& value)
+{
+    boost::property_tree::ptree tree;
+    json::ostream js{tree};
+    by_member(js, value);
+    return json::write(js);
+}
+
+template<typename T>
+bool check(const T& value, const char* what, std::size_t at)
+{
+    const auto expected{per_member(value)};
+    for (const bool copied : {false, true}) {
+        const auto actual{direct(value, copied)};
+        if (actual != expected) {
+            std::cerr << what << " #" << at << (copied ? " (copied)" : "") << " is not the same:\n"
+                      << "direct:     " << actual << "per member: " << expected;
+            return false;
+        }
+    }
+    return true;
+}
+
+}   // end of local namespace
+
+int main(int argc, char** argv)
+{
+    std::size_t count = 1000;
+    unsigned long long seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg.rfind("--count=", 0) == 0) {
+            count = std::stoul(arg.substr(8));
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            seed = std::stoull(arg.substr(7));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--count=<structs of each type>] [--seed=<n>]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    generator make{seed};
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!check(make.make_item(), "item", i) || !check(make.make_tagged(), "tagged", i) ||
+                !check(make.make_group(), "group", i)) {
+            return EXIT_FAILURE;
+        }
+    }
+    std::cout << "the direct members of " << count * 3 << " structs are the same as with a stream for each\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+// Check that arrays that are written with json::parallel are written exactly
+// as they are written in a single thread, with and without indentation.
+// For example:
+//  ./json_parallel_check --count=5000 --threads=4
+// Return 0 when all the outputs are the same, otherwise print the first
+// difference and return 1
+#include "json_parser.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct point
+{
+    int x = 0;
+    int y = 0;
+};
+
+struct item
+{
+    std::string name;
+    std::vector<int> values;
+    point at;
+    std::vector<point> path;
+};
+
+auto operator ^ (json::ostream& os, const point& p) -> json::ostream& {
+    using namespace json::literals;
+    return os ^ "x"_n ^ p.x ^ "y"_n ^ p.y;
+}
+
+auto operator ^ (json::ostream& os, const item& i) -> json::ostream& {
+    using namespace json::literals;
+    os ^ "name"_n ^ i.name;
+    auto values = os ^ "values"_s;
+    values ^ i.values ^ json::_end;
+    auto at = os ^ "at"_s;
+    at ^ i.at ^ json::_end;
+    auto path = os ^ "path"_s;
+    path ^ i.path ^ json::_end;
+    return os;
+}
+
+std::vector<item> make_items(std::size_t count)
+{
+    std::vector<item> items(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto n{static_cast<int>(i)};
+        items[i].name = "item \"" + std::to_string(i) + "\"";
+        for (int v = 0; v < n % 4; ++v) {
+            items[i].values.push_back(n * v - 100);
+        }
+        items[i].at = point{n, -n};
+        for (int p = 0; p < n % 3; ++p) {
+            items[i].path.push_back(point{p, n + p});
+        }
+    }
+    return items;
+}
+
+template<typename Add>
+std::string write_with(Add&& add, bool indent)
+{
+    using namespace json::literals;
+    boost::property_tree::ptree tree;
+    json::ostream js{tree};
+    js ^ "kind"_n ^ "check";
+    auto array = js ^ "items"_s;
+    add(array) ^ json::_end;
+    return json::write(js, indent);
+}
+
+}   // end of local namespace
+
+int main(int argc, char** argv)
+{
+    std::size_t count = 3000;
+    unsigned int threads = 4;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg.rfind("--count=", 0) == 0) {
+            count = std::stoul(arg.substr(8));
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = static_cast<unsigned int>(std::stoul(arg.substr(10)));
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--count=<items>] [--threads=<n>]\n";
+            return EXIT_FAILURE;
+        }
+    }
+    const auto items{make_items(count)};
+    for (const bool indent : {false, true}) {
+        const auto expected{write_with([&] (json::ostream& js) -> json::ostream& { return js ^ items; }, indent)};
+        const auto actual{write_with([&] (json::ostream& js) -> json::ostream& {
+                return js ^ json::parallel(items, threads);
+            }, indent)};
+        if (actual != expected) {
+            std::cerr << "the parallel output is not the same" << (indent ? " with indentation" : "") << ":\n"
+                      << "parallel:   " << actual << "sequential: " << expected;
+            return EXIT_FAILURE;
+        }
+    }
+    std::cout << "the parallel output of " << count << " items is the same as the sequential output\n";
+    return EXIT_SUCCESS;
+}
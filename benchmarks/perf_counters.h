@@ -0,0 +1,198 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __linux__
+#   include <linux/perf_event.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#endif  // __linux__
+
+// Reading the hardware counters of the CPU (with perf_event_open) while the
+// benchmark is running - this shows if a change is better for the branch
+// prediction or for the cache, and not only the time. The counters are often
+// not available (not Linux, in a container or when perf_event_paranoid does
+// not allow it), in this case available() is false and nothing is reported.
+// Only the counters of this thread in user space are counted.
+namespace json::bench
+{
+
+enum class counter_t {
+    cycles,
+    instructions,
+    branch_misses,
+    l1d_misses,
+    llc_misses
+};
+
+constexpr std::size_t counter_count = 5;
+
+inline const char* name(counter_t c)
+{
+    switch (c) {
+    case counter_t::cycles:
+        return "cycles";
+    case counter_t::instructions:
+        return "instructions";
+    case counter_t::branch_misses:
+        return "branch_misses";
+    case counter_t::l1d_misses:
+        return "l1d_misses";
+    case counter_t::llc_misses:
+        return "llc_misses";
+    }
+    return "unknown";
+}
+
+struct counter_values
+{
+    std::array<double, counter_count> values{};
+    std::array<bool, counter_count> valid{};
+
+    double operator [] (counter_t c) const
+    {
+        return values[static_cast<std::size_t>(c)];
+    }
+
+    bool has(counter_t c) const
+    {
+        return valid[static_cast<std::size_t>(c)];
+    }
+};
+
+#ifdef __linux__
+class perf_counters
+{
+public:
+    perf_counters()
+    {
+        // the first counter that we are opening is the group leader, the
+        // others are optional, since not all CPUs have all of them
+        for (std::size_t i = 0; i < counter_count; ++i) {
+            descriptors[i] = open_counter(static_cast<counter_t>(i));
+            if (i == 0 && descriptors[i] < 0) {
+                return;
+            }
+        }
+    }
+
+    ~perf_counters()
+    {
+        for (const auto fd : descriptors) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator = (const perf_counters&) = delete;
+
+    bool available() const
+    {
+        return leader() >= 0;
+    }
+
+    void start()
+    {
+        if (available()) {
+            ::ioctl(leader(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(leader(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    // the counts from the last call to start. If the kernel was not able to
+    // count all the time (there are more counters than the CPU has), the
+    // values are scaled to the full time
+    counter_values stop()
+    {
+        counter_values result;
+        if (!available()) {
+            return result;
+        }
+        ::ioctl(leader(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        // nr, time_enabled, time_running and a value for each counter
+        std::array<std::uint64_t, 3 + counter_count> data{};
+        const auto size{::read(leader(), data.data(), sizeof(data))};
+        if (size < static_cast<ssize_t>(3 * sizeof(std::uint64_t)) || data[2] == 0) {
+            return result;
+        }
+        const auto scale{static_cast<double>(data[1]) / static_cast<double>(data[2])};
+        std::size_t next = 3;
+        for (std::size_t i = 0; i < counter_count && next < 3 + data[0]; ++i) {
+            if (descriptors[i] >= 0) {
+                result.values[i] = static_cast<double>(data[next++]) * scale;
+                result.valid[i] = true;
+            }
+        }
+        return result;
+    }
+
+private:
+    int leader() const
+    {
+        return descriptors[0];
+    }
+
+    int open_counter(counter_t c) const
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.disabled = leader() < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        constexpr auto cache_miss{[] (std::uint64_t cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        }};
+        switch (c) {
+        case counter_t::cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case counter_t::instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case counter_t::branch_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case counter_t::l1d_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_miss(PERF_COUNT_HW_CACHE_L1D);
+            break;
+        case counter_t::llc_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_miss(PERF_COUNT_HW_CACHE_LL);
+            break;
+        }
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, leader(), 0));
+    }
+
+private:
+    std::array<int, counter_count> descriptors{-1, -1, -1, -1, -1};
+};
+#else
+class perf_counters
+{
+public:
+    bool available() const
+    {
+        return false;
+    }
+
+    void start()
+    {
+    }
+
+    counter_values stop()
+    {
+        return counter_values{};
+    }
+};
+#endif  // __linux__
+
+}   // end of namespace json::bench
@@ -83,20 +83,16 @@ auto operator << (std::ostream& os, const baz& b) -> std::ostream& {
 }
 
 BOOST_FUSION_ADAPT_STRUCT(baz, (foo, f)(bar, b));
-auto operator ^ (json::ostream& os, const baz& f) -> json::ostream& {
-    static const char* LABELS[] = {
-        "foo", "baz"
-    };
+// the labels can be set once for the type, and are then used
+// for both reading and writing
+JSON_LABELS(baz, "foo", "baz");
 
-    return json::util::build_entry(os, f, LABELS);
+auto operator ^ (json::ostream& os, const baz& f) -> json::ostream& {
+    return json::util::build_entry(os, f);
 }
 
 auto operator ^ (json::istream& os, baz& f) -> json::istream& {
-    static const char* LABELS[] = {
-        "foo", "baz"
-    };
-
-    return json::util::read_entry(os, f, LABELS);
+    return json::util::read_entry(os, f);
 }
 
 
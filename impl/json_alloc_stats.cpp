@@ -0,0 +1,229 @@
+#include "json_alloc_stats.h"
+#ifdef JSON_PARSER_ALLOC_STATS
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+struct thread_counters
+{
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;
+    std::size_t live = 0;
+    std::size_t peak = 0;
+};
+
+// this has no constructor or destructor, so it is safe
+// to use it from operator new at any time
+thread_local thread_counters counters;
+
+// we are saving the size before the memory that we return, so we would know
+// how much is released. This keeps the alignment of the memory from malloc
+constexpr std::size_t header_size = alignof(std::max_align_t);
+
+// the memory starts at offset from the block, and the size is right before it
+void* count_allocation(unsigned char* block, std::size_t offset, std::size_t size)
+{
+    if (!block) {
+        return nullptr;
+    }
+    auto* memory{block + offset};
+    *reinterpret_cast<std::size_t*>(memory - header_size) = size;
+    ++counters.allocations;
+    counters.bytes += size;
+    counters.live += size;
+    counters.peak = std::max(counters.peak, counters.live);
+    return memory;
+}
+
+void count_release(void* ptr)
+{
+    const auto size{*reinterpret_cast<std::size_t*>(static_cast<unsigned char*>(ptr) - header_size)};
+    // this may be memory from another thread
+    counters.live -= std::min(size, counters.live);
+}
+
+void* allocate(std::size_t size)
+{
+    return count_allocation(static_cast<unsigned char*>(std::malloc(size + header_size)), header_size, size);
+}
+
+void release(void* ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    count_release(ptr);
+    std::free(static_cast<unsigned char*>(ptr) - header_size);
+}
+
+// for alignment that is larger than what malloc gives us, the header takes
+// a whole aligned part before the memory
+std::size_t aligned_offset(std::align_val_t align)
+{
+    return std::max(static_cast<std::size_t>(align), header_size);
+}
+
+void* allocate(std::size_t size, std::align_val_t align)
+{
+    const auto offset{aligned_offset(align)};
+    // the size for aligned_alloc must be a multiple of the alignment
+    const auto total{(size + offset + offset - 1) / offset * offset};
+    return count_allocation(static_cast<unsigned char*>(std::aligned_alloc(offset, total)), offset, size);
+}
+
+void release(void* ptr, std::align_val_t align)
+{
+    if (!ptr) {
+        return;
+    }
+    count_release(ptr);
+    std::free(static_cast<unsigned char*>(ptr) - aligned_offset(align));
+}
+
+template<typename... Align>
+void* allocate_or_throw(std::size_t size, Align... align)
+{
+    while (true) {
+        if (void* ptr{allocate(size, align...)}) {
+            return ptr;
+        }
+        auto handler{std::get_new_handler()};
+        if (!handler) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+
+}   // end of local namespace
+
+void* operator new(std::size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate_or_throw(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    release(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    release(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    release(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    release(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    release(ptr);
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    return allocate_or_throw(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return allocate_or_throw(size, align);
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return allocate(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return allocate(size, align);
+}
+
+void operator delete(void* ptr, std::align_val_t align) noexcept
+{
+    release(ptr, align);
+}
+
+void operator delete[](void* ptr, std::align_val_t align) noexcept
+{
+    release(ptr, align);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept
+{
+    release(ptr, align);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t align) noexcept
+{
+    release(ptr, align);
+}
+
+void operator delete(void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    release(ptr, align);
+}
+
+void operator delete[](void* ptr, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    release(ptr, align);
+}
+
+namespace json
+{
+
+alloc_scope::alloc_scope() :
+        allocations{counters.allocations}, bytes{counters.bytes}, live{counters.live}, outer_peak{counters.peak}
+{
+    // we want the peak from this point
+    counters.peak = counters.live;
+}
+
+alloc_scope::~alloc_scope()
+{
+    counters.peak = std::max(counters.peak, outer_peak);
+}
+
+alloc_stats alloc_scope::stats() const
+{
+    return alloc_stats{
+        counters.allocations - allocations,
+        counters.bytes - bytes,
+        counters.peak - std::min(counters.peak, live)
+    };
+}
+
+}   // end of namespace json
+
+#endif  // JSON_PARSER_ALLOC_STATS
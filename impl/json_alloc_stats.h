@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+
+// Counting the memory allocations, to see how much each operation costs us. This
+// is only enabled when building with JSON_PARSER_ALLOC_STATS (cmake option with
+// the same name) - in this case the global operator new and delete are replaced
+// with versions that count the allocations of each thread (including the
+// aligned versions). Otherwise the counters
+// are always 0, and there is no cost for it.
+//  json::alloc_scope scope;
+//  root.open(message);
+//  const auto stats{scope.stats()};
+//  std::cout << stats.allocations << " allocations, " << stats.bytes << " bytes\n";
+namespace json
+{
+
+#ifdef JSON_PARSER_ALLOC_STATS
+constexpr bool alloc_stats_enabled = true;
+#else
+constexpr bool alloc_stats_enabled = false;
+#endif  // JSON_PARSER_ALLOC_STATS
+
+struct alloc_stats
+{
+    std::size_t allocations = 0;    // the number of calls to operator new
+    std::size_t bytes = 0;          // the number of bytes that were allocated
+    std::size_t peak_bytes = 0;     // the max bytes that were allocated and not released at the same time
+};
+
+// the two versions of this are in different namespaces, so code that is
+// built with and without JSON_PARSER_ALLOC_STATS can be linked together.
+// Note that only the library that is built with it is counting, so using the
+// counting version with a library that was built without it fails to link
+#ifdef JSON_PARSER_ALLOC_STATS
+inline namespace measured
+{
+
+// the allocations of this thread from the time the scope was created. Note that
+// memory that is released by another thread is not counted as released
+class alloc_scope
+{
+public:
+    alloc_scope();
+    ~alloc_scope();
+
+    alloc_scope(const alloc_scope&) = delete;
+    alloc_scope& operator = (const alloc_scope&) = delete;
+
+    alloc_stats stats() const;
+
+private:
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;
+    std::size_t live = 0;
+    std::size_t outer_peak = 0;
+};
+
+}   // end of namespace measured
+#else
+inline namespace not_measured
+{
+
+class alloc_scope
+{
+public:
+    alloc_scope() = default;
+
+    alloc_scope(const alloc_scope&) = delete;
+    alloc_scope& operator = (const alloc_scope&) = delete;
+
+    alloc_stats stats() const
+    {
+        return alloc_stats{};
+    }
+};
+
+}   // end of namespace not_measured
+#endif  // JSON_PARSER_ALLOC_STATS
+
+}   // end of namespace json
@@ -0,0 +1,306 @@
+#pragma once
+#include "json_istream.h"
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+namespace json
+{
+
+// Read the items of a message that is a single large array, one item at a time.
+// Only the text of the current item is kept in memory, so this can be used for
+// inputs that are too large to read with istream_root:
+//  json::array_stream<record> records{std::filesystem::path{"export.json"}};
+//  for (const auto& r : records) {
+//      ...
+//  }
+//  if (!records.good()) {
+//      // the input is not valid, or an item could not be read as record
+//  }
+// The items are read with operator ^ for json::istream (as they are read into
+// std::vector<T>), so T must have it and be default constructible. This is an
+// input range - it can be iterated once, and works with the std::ranges
+// algorithms and views. The input is UTF-8, for the wide version the text of
+// each item is converted to wchar_t.
+template<typename T, typename Ch = char>
+class basic_array_stream
+{
+public:
+    using value_type = T;
+
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    class iterator
+    {
+    public:
+        using iterator_concept = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        explicit iterator(basic_array_stream* s) : stream{s}
+        {
+        }
+
+        // the item can be moved from, it is replaced by the next one
+        T& operator * () const
+        {
+            return stream->current;
+        }
+
+        T* operator -> () const
+        {
+            return &stream->current;
+        }
+
+        iterator& operator ++ ()
+        {
+            stream->next();
+            return *this;
+        }
+
+        void operator ++ (int)
+        {
+            ++*this;
+        }
+
+        friend bool operator == (const iterator& i, std::default_sentinel_t)
+        {
+            return i.at_end();
+        }
+
+    private:
+        bool at_end() const
+        {
+            return stream == nullptr || stream->finished;
+        }
+
+    private:
+        basic_array_stream* stream = nullptr;
+    };
+
+    // the stream must be valid as long as we are reading from it
+    explicit basic_array_stream(std::istream& input, std::size_t chunk_size = default_chunk_size) :
+            source{&input}, chunk{chunk_size}
+    {
+    }
+
+    explicit basic_array_stream(const std::filesystem::path& file_path, std::size_t chunk_size = default_chunk_size) :
+            file{file_path, std::ios::binary}, source{&file}, chunk{chunk_size}
+    {
+        if (!file) {
+            fail();
+        }
+    }
+
+    basic_array_stream(const basic_array_stream&) = delete;
+    basic_array_stream& operator = (const basic_array_stream&) = delete;
+
+    // the first call reads the first item, after that this is the current item
+    iterator begin()
+    {
+        if (!started) {
+            started = true;
+            if (!finished && open_array()) {
+                next();
+            }
+        }
+        return iterator{this};
+    }
+
+    std::default_sentinel_t end() const
+    {
+        return std::default_sentinel;
+    }
+
+    // false when the input is not a valid array, or an item could not be read
+    bool good() const
+    {
+        return state;
+    }
+
+    // the number of items that were read so far
+    std::size_t count() const
+    {
+        return items;
+    }
+
+private:
+    void fail()
+    {
+        state = false;
+        finished = true;
+    }
+
+    bool fill()
+    {
+        if (!source->good()) {
+            return false;
+        }
+        buffer.resize(chunk);
+        source->read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.resize(static_cast<std::size_t>(source->gcount()));
+        pos = 0;
+        return !buffer.empty();
+    }
+
+    // the next char that is not white space, or -1 at the end of the input
+    int peek()
+    {
+        while (true) {
+            if (pos == buffer.size() && !fill()) {
+                return -1;
+            }
+            const char c{buffer[pos]};
+            if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+                return static_cast<unsigned char>(c);
+            }
+            ++pos;
+        }
+    }
+
+    bool open_array()
+    {
+        // skip the byte order mark
+        if (peek() == 0xef) {
+            for (int i = 0; i < 3; ++i, ++pos) {
+                if (pos == buffer.size() && !fill()) {
+                    fail();
+                    return false;
+                }
+            }
+        }
+        if (peek() != '[') {
+            fail();
+            return false;
+        }
+        ++pos;
+        if (peek() == ']') {
+            ++pos;
+            close_array();
+            return false;
+        }
+        return true;
+    }
+
+    // only white space is allowed after the array
+    void close_array()
+    {
+        finished = true;
+        if (peek() != -1) {
+            state = false;
+        }
+    }
+
+    void next()
+    {
+        if (finished) {
+            return;
+        }
+        if (items > 0) {
+            const auto c{peek()};
+            if (c == ']') {
+                ++pos;
+                close_array();
+                return;
+            }
+            if (c != ',') {
+                fail();
+                return;
+            }
+            ++pos;
+        }
+        if (!read_item()) {
+            fail();
+            return;
+        }
+        try {
+            if (!root.open(std::move(text))) {
+                fail();
+                return;
+            }
+            auto js{root ^ _root};
+            current = T{};
+            js ^ _name("") ^ current;
+            if (!js) {
+                fail();
+                return;
+            }
+        } catch (const std::exception&) {
+            fail();
+            return;
+        }
+        ++items;
+    }
+
+    // copy the text of the next item - it ends with ',' or ']' that is not
+    // inside an object, array or string. The text is checked when we parse it
+    bool read_item()
+    {
+        text.clear();
+        if (peek() == -1) {
+            return false;
+        }
+        int depth = 0;
+        bool in_string = false;
+        bool escape = false;
+        while (true) {
+            const std::size_t from{pos};
+            for (; pos < buffer.size(); ++pos) {
+                const char c{buffer[pos]};
+                if (in_string) {
+                    if (escape) {
+                        escape = false;
+                    } else if (c == '\\') {
+                        escape = true;
+                    } else if (c == '"') {
+                        in_string = false;
+                    }
+                } else if (c == '"') {
+                    in_string = true;
+                } else if (c == '{' || c == '[') {
+                    ++depth;
+                } else if (c == '}' || c == ']') {
+                    if (depth == 0) {
+                        break;
+                    }
+                    --depth;
+                } else if (c == ',' && depth == 0) {
+                    break;
+                }
+            }
+            text.append(buffer.data() + from, pos - from);
+            if (pos < buffer.size()) {
+                return true;
+            }
+            if (!fill()) {
+                return false;   // the input ended inside the array
+            }
+        }
+    }
+
+private:
+    std::ifstream file;
+    std::istream* source = nullptr;
+    std::size_t chunk = default_chunk_size;
+    std::string buffer;
+    std::size_t pos = 0;
+    std::string text;
+    basic_istream_root<Ch> root;
+    T current{};
+    std::size_t items = 0;
+    bool started = false;
+    bool finished = false;
+    bool state = true;
+};
+
+template<typename T>
+using array_stream = basic_array_stream<T, char>;
+template<typename T>
+using warray_stream = basic_array_stream<T, wchar_t>;
+
+}   // end of namespace json
@@ -1,32 +1,122 @@
 #include "json_base.h"
+#include <cstdint>
+#include <cstring>
 
 namespace json
 {
 
-std::wstring widen_str(const std::string& str)
+namespace
 {
-    std::wostringstream wstm;
 
-    const std::ctype<wchar_t>& ctfacet = std::use_facet<std::ctype<wchar_t> >(wstm.getloc());
+constexpr wchar_t replacement_char = 0xfffd;
+
+bool is_trail(unsigned char c)
+{
+    return (c & 0xc0) == 0x80;
+}
 
-    for(size_t i = 0; i < str.size(); ++i) {
-        wstm<<ctfacet.widen(str[i]);
+// write a code point as wchar_t - this is UTF-32 where wchar_t is
+// 32 bits and UTF-16 where it is 16 bits
+wchar_t* put_code_point(wchar_t* to, char32_t code)
+{
+    if constexpr (sizeof(wchar_t) == 2) {
+        if (code >= 0x10000) {
+            code -= 0x10000;
+            *to++ = static_cast<wchar_t>(0xd800 | (code >> 10));
+            *to++ = static_cast<wchar_t>(0xdc00 | (code & 0x3ff));
+            return to;
+        }
     }
-    return wstm.str();
+    *to++ = static_cast<wchar_t>(code);
+    return to;
 }
 
-std::wstring widen_str(const char* str)
+// decode the UTF-8 sequence that is starting at from (this is not ASCII),
+// invalid sequences are replaced with U+FFFD, one for each byte
+const char* decode_sequence(const char* from, const char* end, char32_t& code)
 {
-    size_t len = strlen(str);
+    const auto lead{static_cast<unsigned char>(*from)};
+    code = replacement_char;
+    int trailing = 0;
+    unsigned char low = 0x80;   // the limits for the first trailing byte, to reject
+    unsigned char high = 0xbf;  // overlong forms, surrogates and values above 0x10ffff
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        trailing = 1;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        trailing = 2;
+        low = lead == 0xe0 ? 0xa0 : 0x80;
+        high = lead == 0xed ? 0x9f : 0xbf;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        trailing = 3;
+        low = lead == 0xf0 ? 0x90 : 0x80;
+        high = lead == 0xf4 ? 0x8f : 0xbf;
+    } else {
+        return from + 1;
+    }
+    if (end - from <= trailing) {
+        return from + 1;
+    }
+    const auto first{static_cast<unsigned char>(from[1])};
+    if (first < low || first > high) {
+        return from + 1;
+    }
+    char32_t value{static_cast<char32_t>(lead & (0x3f >> trailing))};
+    for (int i = 1; i <= trailing; ++i) {
+        const auto c{static_cast<unsigned char>(from[i])};
+        if (!is_trail(c)) {
+            return from + 1;
+        }
+        value = (value << 6) | (c & 0x3f);
+    }
+    code = value;
+    return from + trailing + 1;
+}
 
-    std::wostringstream wstm;
+std::wstring to_wide(const char* from, std::size_t size)
+{
+    // each byte is at most one wchar_t, even 4 bytes sequences with UTF-16
+    std::wstring result(size, L'\0');
+    wchar_t* to{result.data()};
+    const char* end{from + size};
+    while (from != end) {
+        // most of the input is ASCII - copy it 8 bytes at a time
+        while (end - from >= 8) {
+            std::uint64_t block;
+            std::memcpy(&block, from, sizeof(block));
+            if (block & 0x8080808080808080ull) {
+                break;
+            }
+            for (int i = 0; i < 8; ++i) {
+                to[i] = static_cast<wchar_t>(from[i]);
+            }
+            from += 8;
+            to += 8;
+        }
+        if (from == end) {
+            break;
+        }
+        if (static_cast<unsigned char>(*from) < 0x80) {
+            *to++ = static_cast<wchar_t>(*from++);
+        } else {
+            char32_t code;
+            from = decode_sequence(from, end, code);
+            to = put_code_point(to, code);
+        }
+    }
+    result.resize(static_cast<std::size_t>(to - result.data()));
+    return result;
+}
 
-    const std::ctype<wchar_t>& ctfacet = std::use_facet<std::ctype<wchar_t> >(wstm.getloc());
+}   // end of local namespace
 
-    for(size_t i = 0; i < len; ++i) {
-        wstm<<ctfacet.widen(str[i]);
-    }
-    return wstm.str();
+std::wstring widen_str(const std::string& str)
+{
+    return to_wide(str.data(), str.size());
+}
+
+std::wstring widen_str(const char* str)
+{
+    return to_wide(str, std::strlen(str));
 }
 
 }   // end of namespace json
@@ -1,19 +1,37 @@
 #pragma once
+#include "json_emit.h"
+#include "json_format.h"
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <sstream>
+#include <string_view>
 
 namespace json
 {
 
 // this is when we have a value that is formatted already
-// and we don't need to quote it like other strings
+// and we don't need to quote it like other strings.
+// The value is copied into the message, and written as is (see
+// details::raw_marker for how it is stored in the tree)
 struct sub_tree {
 	sub_tree(const std::string& s);
 
 	const std::string& entry;
 };
 
+// the same as sub_tree, for a value that is not held by a string - for
+// example the text of a raw_view. The value is copied into the message
+// as well, so it only needs to be valid while it is added
+struct sub_tree_ref {
+    explicit sub_tree_ref(std::string_view s) : entry(s)
+    {
+    }
+
+    std::string_view entry;
+};
+
+// convert UTF-8 to wide string (UTF-32, or UTF-16 where wchar_t is 16 bits),
+// invalid input is replaced with U+FFFD
 std::wstring widen_str(const std::string& str);
 std::wstring widen_str(const char* str);
 
@@ -28,16 +46,36 @@ struct entry
 
     void write(boost::property_tree::ptree& to) const
     {
-        to.put<value_type>(name, value);
+        if constexpr (details::is_native_number_v<value_type>) {
+            to.put(name, format<char>());
+        } else {
+            to.put<value_type>(name, value);
+        }
     }
 
     void write(boost::property_tree::wptree& to) const
     {
-        to.put<value_type>(widen_str(name), value);
+        if constexpr (details::is_native_number_v<value_type>) {
+            to.put(widen_str(name), format<wchar_t>());
+        } else {
+            to.put<value_type>(widen_str(name), value);
+        }
     }
 
     const char* name;
     value_type value;
+
+private:
+    // numbers are formatted directly, and not with the tree
+    // translator, that is using string stream for it
+    template<typename Ch>
+    std::basic_string<Ch> format() const
+    {
+        char buffer[details::max_number_chars<value_type>()];
+        std::basic_string<Ch> result;
+        details::append_ascii(result, buffer, details::format_number<value_type>(buffer, value));
+        return result;
+    }
 };
 
 template<>
@@ -86,13 +124,41 @@ struct entry<sub_tree>
 
 	void write(boost::property_tree::ptree& to) const
 	{
-		to.put<std::string>(name, value.entry);
+		to.put<std::string>(name, details::make_raw_value<char>(value.entry));
+	}
+
+	void write(boost::property_tree::wptree& to) const
+	{
+		to.put<std::wstring>(widen_str(name), details::make_raw_value<wchar_t>(widen_str(value.entry)));
 	}
 
 	const char* name;
 	value_type  value;
 };
 
+template<>
+struct entry<sub_tree_ref>
+{
+    typedef sub_tree_ref value_type;
+
+    explicit entry(const char* n, const value_type& v) : name(n), value(v)
+    {
+    }
+
+    void write(boost::property_tree::ptree& to) const
+    {
+        to.put<std::string>(name, details::make_raw_value<char>(value.entry));
+    }
+
+    void write(boost::property_tree::wptree& to) const
+    {
+        to.put<std::wstring>(widen_str(name), details::make_raw_value<wchar_t>(widen_str(std::string{value.entry})));
+    }
+
+    const char* name;
+    value_type  value;
+};
+
 template<>
 struct entry<std::wstring>
 {
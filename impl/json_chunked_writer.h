@@ -0,0 +1,313 @@
+#pragma once
+#include "json_emit.h"
+#include "json_ostream.h"
+#include <algorithm>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json
+{
+
+// Write a message in chunks of bounded size, so it can be sent over a non
+// blocking socket as it becomes writable, without writing all of it into
+// memory first. The writer keeps its location in the message between the
+// calls, for example:
+//  json::chunked_writer writer{message};
+//  std::array<char, 4096> buffer;
+//  for (std::span<char> out{buffer}; writer.next_chunk(out); out = buffer) {
+//      send(out);
+//  }
+// Note that the message (output_stream, ostream or the tree) must be valid
+// as long as the writer is used - unless the writer was created with from,
+// in which case it owns the message
+template<typename Ch>
+class basic_chunked_writer
+{
+public:
+    using char_type = Ch;
+    using proptree_type = typename ptree_type<char_type>::proptree_type;
+    using string_type = std::basic_string<char_type>;
+
+    static constexpr std::size_t default_chunk_size = 16 * 1024;
+
+    explicit basic_chunked_writer(const proptree_type& tree, bool indent = false,
+                std::size_t chunk = default_chunk_size) :
+                    root{&tree}, pretty{indent}, chunk_size{std::max<std::size_t>(chunk, 16)}
+    {
+        start();
+    }
+
+    explicit basic_chunked_writer(const basic_output_stream<char_type>& os, bool indent = false,
+                std::size_t chunk = default_chunk_size) :
+                    basic_chunked_writer{os.tree_root, indent, chunk}
+    {
+    }
+
+    explicit basic_chunked_writer(const basic_ostream<char_type>& os, bool indent = false,
+                std::size_t chunk = default_chunk_size) :
+                    basic_chunked_writer{os.entries(), indent, chunk}
+    {
+    }
+
+    // create the message from any type that has operator ^ for json::ostream,
+    // the writer owns this message
+    template<typename T>
+    static basic_chunked_writer from(const T& obj, bool indent = false, std::size_t chunk = default_chunk_size)
+    {
+        auto message{std::make_unique<basic_output_stream<char_type>>()};
+        auto js{*message ^ open};
+        js ^ obj;
+        basic_chunked_writer writer{message->tree_root, indent, chunk};
+        writer.owned = std::move(message);
+        return writer;
+    }
+
+    // write the next part of the message into out - no more than out size.
+    // On return out is set to the part that was written. Return false when
+    // there is nothing more to write - for an empty out, nothing is written
+    // and this is true as long as the message is not done
+    bool next_chunk(std::span<char_type>& out)
+    {
+        if (out.empty()) {
+            return !done();
+        }
+        std::size_t written = 0;
+        while (written < out.size()) {
+            if (pending_at == pending.size()) {
+                pending.clear();
+                pending_at = 0;
+                if (!produce(std::min(out.size() - written, chunk_size))) {
+                    break;
+                }
+            }
+            const auto count{std::min(pending.size() - pending_at, out.size() - written)};
+            std::char_traits<char_type>::copy(out.data() + written, pending.data() + pending_at, count);
+            written += count;
+            pending_at += count;
+        }
+        out = out.first(written);
+        return written > 0;
+    }
+
+    // write the next part of the message into internal buffer of chunk size.
+    // return empty result when there is nothing more to write. The result
+    // is valid until the next call
+    std::span<const char_type> next_chunk()
+    {
+        buffer.resize(chunk_size);
+        std::span<char_type> out{buffer};
+        next_chunk(out);
+        return out;
+    }
+
+    // we are done once all the message was written
+    bool done() const
+    {
+        return stage == stage_t::DONE && pending_at == pending.size();
+    }
+
+    // the message cannot be written as JSON - in this case nothing is written
+    bool bad() const
+    {
+        return failed;
+    }
+
+private:
+    enum class stage_t {
+        NODE,           // start writing the node at the top of the stack
+        NEXT_CHILD,     // write the next child of the object or array at the top of the stack
+        KEY,            // in the middle of writing a key
+        VALUE,          // in the middle of writing a value
+        RAW,            // in the middle of writing a value that is not escaped
+        AFTER_CHILD,    // done with a child - add separator
+        DONE
+    };
+
+    struct frame
+    {
+        const proptree_type* node = nullptr;
+        typename proptree_type::const_iterator current;
+        bool array = false;
+        int indent = 0;
+    };
+
+    void start()
+    {
+        if (!details::verify_tree(*root, 0)) {
+            failed = true;
+            stage = stage_t::DONE;
+            return;
+        }
+        next_node = root;
+        next_indent = 0;
+        stage = stage_t::NODE;
+    }
+
+    // generate about limit chars into the pending buffer,
+    // return false if there is nothing more to generate
+    bool produce(std::size_t limit)
+    {
+        details::append_sink<char_type> sink{pending};
+        while (pending.size() < limit && stage != stage_t::DONE) {
+            switch (stage) {
+            case stage_t::NODE:
+                open_node(sink);
+                break;
+            case stage_t::NEXT_CHILD:
+                next_child(sink);
+                break;
+            case stage_t::KEY:
+            case stage_t::VALUE:
+            case stage_t::RAW:
+                escape(sink, limit);
+                break;
+            case stage_t::AFTER_CHILD:
+                after_child(sink);
+                break;
+            case stage_t::DONE:
+                break;
+            }
+        }
+        return !pending.empty();
+    }
+
+    void open_node(details::append_sink<char_type>& sink)
+    {
+        if (next_node->empty() && details::is_raw_value(next_node->data())) {
+            raw = details::raw_text(next_node->data());
+            escape_at = 0;
+            stage = stage_t::RAW;
+            return;
+        }
+        if (next_indent > 0 && next_node->empty()) {
+            start_escape(next_node->data(), stage_t::VALUE);
+            return;
+        }
+        const bool array{details::is_array_node(*next_node)};
+        sink.put(array ? char_type('[') : char_type('{'));
+        new_line(sink);
+        stack.push_back(frame{next_node, next_node->begin(), array, next_indent});
+        stage = stage_t::NEXT_CHILD;
+    }
+
+    void next_child(details::append_sink<char_type>& sink)
+    {
+        auto& top{stack.back()};
+        if (top.current == top.node->end()) {
+            spaces(sink, top.indent);
+            sink.put(top.array ? char_type(']') : char_type('}'));
+            stack.pop_back();
+            if (stack.empty()) {
+                sink.put(char_type('\n'));
+                stage = stage_t::DONE;
+            } else {
+                stage = stage_t::AFTER_CHILD;
+            }
+            return;
+        }
+        spaces(sink, top.indent + 1);
+        next_node = &top.current->second;
+        next_indent = top.indent + 1;
+        if (top.array) {
+            stage = stage_t::NODE;
+        } else {
+            sink.put(char_type('"'));
+            start_escape(top.current->first, stage_t::KEY);
+        }
+    }
+
+    void after_child(details::append_sink<char_type>& sink)
+    {
+        auto& top{stack.back()};
+        if (++top.current != top.node->end()) {
+            sink.put(char_type(','));
+        }
+        new_line(sink);
+        stage = stage_t::NEXT_CHILD;
+    }
+
+    void start_escape(const string_type& str, stage_t what)
+    {
+        escaping = &str;
+        escape_at = 0;
+        stage = what;
+    }
+
+    // write the part of the string that we are escaping (or copying if this
+    // is raw value) - we are doing this in parts, so we would not need to hold
+    // large strings in memory
+    void escape(details::append_sink<char_type>& sink, std::size_t limit)
+    {
+        const auto room{limit - std::min(limit, pending.size())};
+        if (stage == stage_t::RAW) {
+            const auto count{std::min(raw.size() - escape_at, std::max<std::size_t>(room, 1))};
+            sink.write(raw.data() + escape_at, count);
+            escape_at += count;
+            if (escape_at < raw.size()) {
+                return;
+            }
+        } else {
+            const char_type* start{escaping->data()};
+            const char_type* end{start + escaping->size()};
+            // each char can be at most 2 chars after the escape
+            const auto count{std::min(escaping->size() - escape_at, std::max<std::size_t>(room / 2, 1))};
+            details::write_escaped(sink, start, end, start + escape_at, start + escape_at + count);
+            escape_at += count;
+            if (escape_at < escaping->size()) {
+                return;
+            }
+        }
+        if (stage == stage_t::KEY) {
+            sink.put(char_type('"'));
+            sink.put(char_type(':'));
+            if (pretty) {
+                sink.put(char_type(' '));
+            }
+            stage = stage_t::NODE;
+        } else if (stack.empty()) {
+            sink.put(char_type('\n'));
+            stage = stage_t::DONE;
+        } else {
+            stage = stage_t::AFTER_CHILD;
+        }
+    }
+
+    void spaces(details::append_sink<char_type>& sink, int level) const
+    {
+        if (pretty) {
+            sink.fill(char_type(' '), static_cast<std::size_t>(4 * level));
+        }
+    }
+
+    void new_line(details::append_sink<char_type>& sink) const
+    {
+        if (pretty) {
+            sink.put(char_type('\n'));
+        }
+    }
+
+private:
+    std::unique_ptr<basic_output_stream<char_type>> owned;
+    const proptree_type* root = nullptr;
+    bool pretty = false;
+    bool failed = false;
+    std::size_t chunk_size = default_chunk_size;
+    stage_t stage = stage_t::DONE;
+    std::vector<frame> stack;
+    const proptree_type* next_node = nullptr;
+    int next_indent = 0;
+    const string_type* escaping = nullptr;
+    std::basic_string_view<char_type> raw;
+    std::size_t escape_at = 0;
+    string_type pending;
+    std::size_t pending_at = 0;
+    string_type buffer;
+};
+
+using chunked_writer = basic_chunked_writer<char>;
+using wchunked_writer = basic_chunked_writer<wchar_t>;
+
+}   // end of namespace json
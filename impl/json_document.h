@@ -0,0 +1,1201 @@
+#pragma once
+#include "json_stream.h"
+#include "json_projection.h"
+#include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Reading JSON text into the property tree. This builds the same tree as boost
+// read_json does (values are stored as text, strings without the quotes and with
+// the escapes decoded, and the same input is accepted or rejected), only that it
+// is working directly on the input text and not on a stream, and that it can
+// record the location and the type of each value in the input. This allow us
+// to give access to the original text of the values after the parsing is done,
+// and to read numbers without converting the text again.
+namespace json
+{
+
+// the type of a value as it was in the input
+enum class value_kind : std::uint8_t
+{
+    null,
+    boolean,
+    integer,            // a number without fraction or exponent that fits in int64
+    unsigned_integer,   // a number without fraction or exponent that only fits in uint64
+    real,
+    string,
+    object,
+    array
+};
+
+namespace details
+{
+
+// what we know about a value in the input text - its location, its type, and for
+// numbers and booleans the value (when decoded is true)
+struct value_info
+{
+    std::size_t offset = 0;
+    std::size_t size = 0;
+    value_kind kind = value_kind::null;
+    bool decoded = false;
+    union
+    {
+        bool boolean;
+        std::int64_t integer;
+        std::uint64_t unsigned_integer;
+        double real;
+    } value{};
+};
+
+// map from the nodes in the tree to the information that we collected about them
+// while parsing. Once a node is in the tree it is not moving, so we can use its
+// address. While parsing we are only adding the entries to a list, the lookup
+// table is created the first time we are looking for a node, so we don't pay
+// for it when the information is not used
+template<typename Node, typename Info>
+class node_map
+{
+public:
+    node_map() = default;
+    node_map(const node_map&) = delete;
+    node_map& operator = (const node_map&) = delete;
+
+    void clear()
+    {
+        items.clear();
+        table.clear();
+        indexed = std::make_unique<std::once_flag>();
+    }
+
+    void insert(const Node* node, const Info& info)
+    {
+        items.emplace_back(node, info);
+    }
+
+    // take all the entries of other, where the node from was moved into the
+    // node to (all the other nodes keep their addresses when a tree is moved)
+    void take(node_map& other, const Node* from, const Node* to)
+    {
+        clear();
+        items.swap(other.items);
+        other.clear();
+        // the root is added last, so it is usually the last entry
+        for (auto item{items.rbegin()}; item != items.rend(); ++item) {
+            if (item->first == from) {
+                item->first = to;
+                break;
+            }
+        }
+    }
+
+    const Info* find(const Node* node) const
+    {
+        std::call_once(*indexed, [this] () { build(); });
+        if (table.empty()) {
+            return nullptr;
+        }
+        const auto mask{table.size() - 1};
+        for (auto i = slot(node, mask); table[i] != empty_slot; i = (i + 1) & mask) {
+            if (items[table[i]].first == node) {
+                return &items[table[i]].second;
+            }
+        }
+        return nullptr;
+    }
+
+    std::size_t size() const
+    {
+        return items.size();
+    }
+
+private:
+    static constexpr std::uint32_t empty_slot = ~std::uint32_t{0};
+
+    static std::size_t slot(const Node* node, std::size_t mask)
+    {
+        // the low bits of the address are the same for all nodes
+        const auto key{static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(node) >> 4)};
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    }
+
+    void build() const
+    {
+        if (items.empty()) {
+            return;
+        }
+        std::size_t size = 16;
+        while (size < items.size() * 2) {
+            size *= 2;
+        }
+        table.assign(size, empty_slot);
+        const auto mask{size - 1};
+        for (std::size_t n = 0; n < items.size(); ++n) {
+            auto i{slot(items[n].first, mask)};
+            while (table[i] != empty_slot) {
+                i = (i + 1) & mask;
+            }
+            table[i] = static_cast<std::uint32_t>(n);
+        }
+    }
+
+    std::vector<std::pair<const Node*, Info>> items;
+    mutable std::vector<std::uint32_t> table;
+    std::unique_ptr<std::once_flag> indexed = std::make_unique<std::once_flag>();
+};
+
+// Index of the children of the objects in the tree by their keys. Each key is
+// interned once for the document and given an id, and the children are found
+// by the address of their parent and the id of the key. So finding a child is
+// a single lookup of the key text - that is also telling us right away when
+// there is no such key anywhere in the document - and then comparing ids, and
+// not comparing the key with the keys of the other children. As with node_map,
+// the index is created the first time we are looking for a child, and it is
+// valid as long as the tree is not changed
+template<typename Node>
+class key_index
+{
+public:
+    using char_type = typename Node::key_type::value_type;
+    using view_type = std::basic_string_view<char_type>;
+
+    key_index() = default;
+    key_index(const key_index&) = delete;
+    key_index& operator = (const key_index&) = delete;
+
+    void reset(const Node* from)
+    {
+        root = from;
+        ids.clear();
+        children.clear();
+        indexed = std::make_unique<std::once_flag>();
+    }
+
+    // the first child of parent with this key (this is the one that the tree
+    // is finding as well), or null if there is none
+    const Node* find(const Node& parent, view_type key) const
+    {
+        std::call_once(*indexed, [this] () { build(); });
+        const auto id{ids.find(key)};
+        if (id == ids.end()) {
+            return nullptr;
+        }
+        const auto child{children.find(child_key{&parent, id->second})};
+        return child == children.end() ? nullptr : child->second;
+    }
+
+private:
+    struct child_key
+    {
+        const Node* parent = nullptr;
+        std::uint32_t id = 0;
+
+        bool operator == (const child_key&) const = default;
+    };
+
+    struct child_hash
+    {
+        std::size_t operator () (const child_key& key) const
+        {
+            // the low bits of the address are the same for all nodes
+            const auto at{static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key.parent) >> 4)};
+            return static_cast<std::size_t>((at ^ (std::uint64_t{key.id} << 40)) * 0x9E3779B97F4A7C15ull >> 16);
+        }
+    };
+
+    void build() const
+    {
+        if (root) {
+            add(*root);
+        }
+    }
+
+    // the keys are views of the keys in the tree, these are not moving
+    void add(const Node& parent) const
+    {
+        for (const auto& child : parent) {
+            if (!child.first.empty()) {
+                const auto id{ids.try_emplace(view_type{child.first}, static_cast<std::uint32_t>(ids.size())).first->second};
+                children.try_emplace(child_key{&parent, id}, &child.second);
+            }
+            add(child.second);
+        }
+    }
+
+    const Node* root = nullptr;
+    mutable std::unordered_map<view_type, std::uint32_t> ids;
+    mutable std::unordered_map<child_key, const Node*, child_hash> children;
+    std::unique_ptr<std::once_flag> indexed = std::make_unique<std::once_flag>();
+};
+
+template<typename Ch>
+constexpr bool is_digit(Ch c)
+{
+    return c >= Ch('0') && c <= Ch('9');
+}
+
+template<typename Ch>
+class tree_parser
+{
+public:
+    using proptree_type = typename ptree_type<Ch>::proptree_type;
+    using string_type = std::basic_string<Ch>;
+    using locations_type = node_map<proptree_type, value_info>;
+    using projection_type = basic_projection<Ch>;
+
+    static constexpr std::size_t all = projection_type::npos;
+
+    // when locations is given, the location and type of each node is saved into
+    // it. When fields is given, only the paths in it are added to the tree
+    tree_parser(const Ch* from, const Ch* to, locations_type* where = nullptr,
+                const projection_type* fields = nullptr) :
+            start{from}, cur{from}, end{to}, locations{where}, projection{fields}
+    {
+        if (projection) {
+            remaining = projection->stop_after();
+        }
+    }
+
+    // parse the input into root, return false if this is not a valid JSON
+    bool parse(proptree_type& root)
+    {
+        skip_introduction();
+        if (!parse_value(root, projection ? 0 : all)) {
+            return false;
+        }
+        if (done) {
+            return true;    // we have all the fields, the rest is not checked
+        }
+        skip_ws();
+        return cur == end;  // we don't allow anything after the data
+    }
+
+private:
+    // field is the location of the node in the projection, or all when the
+    // whole value is added
+    bool parse_value(proptree_type& node, std::size_t field = all)
+    {
+        skip_ws();
+        if (cur == end) {
+            return false;
+        }
+        const Ch* from{cur};
+        value_info info;
+        bool ok = false;
+        if (field != all && !projection->at(field).whole) {
+            // on the path to the fields - only objects and arrays can lead to them
+            if (*cur == Ch('{')) {
+                info.kind = value_kind::object;
+                ok = project_object(node, field);
+            } else if (*cur == Ch('[')) {
+                info.kind = value_kind::array;
+                ok = project_array(node, field);
+            } else {
+                return skip_value();
+            }
+            if (ok && locations && !done) {
+                info.offset = static_cast<std::size_t>(from - start);
+                info.size = static_cast<std::size_t>(cur - from);
+                locations->insert(&node, info);
+            }
+            return ok;
+        }
+        switch (*cur) {
+        case Ch('{'):
+            info.kind = value_kind::object;
+            ok = parse_object(node);
+            break;
+        case Ch('['):
+            info.kind = value_kind::array;
+            ok = parse_array(node);
+            break;
+        case Ch('"'):
+            info.kind = value_kind::string;
+            ++cur;
+            ok = parse_string(node.data());
+            break;
+        case Ch('t'):
+        case Ch('f'):
+            info.kind = value_kind::boolean;
+            info.decoded = true;
+            info.value.boolean = *cur == Ch('t');
+            ok = parse_literal(node.data(), info.value.boolean ? "true" : "false");
+            break;
+        case Ch('n'):
+            info.kind = value_kind::null;
+            ok = parse_literal(node.data(), "null");
+            break;
+        default:
+            ok = parse_number(node.data(), info);
+            break;
+        }
+        if (ok && locations) {
+            info.offset = static_cast<std::size_t>(from - start);
+            info.size = static_cast<std::size_t>(cur - from);
+            locations->insert(&node, info);
+        }
+        return ok;
+    }
+
+    bool parse_object(proptree_type& node)
+    {
+        ++cur;
+        skip_ws();
+        if (cur != end && *cur == Ch('}')) {
+            ++cur;
+            return true;
+        }
+        string_type key;
+        while (true) {
+            skip_ws();
+            if (cur == end || *cur != Ch('"')) {
+                return false;
+            }
+            ++cur;
+            key.clear();
+            if (!parse_string(key)) {
+                return false;
+            }
+            skip_ws();
+            if (cur == end || *cur != Ch(':')) {
+                return false;
+            }
+            ++cur;
+            auto& child{node.push_back(typename proptree_type::value_type{key, proptree_type{}})->second};
+            if (!parse_value(child)) {
+                return false;
+            }
+            skip_ws();
+            if (cur == end) {
+                return false;
+            }
+            if (*cur == Ch('}')) {
+                ++cur;
+                return true;
+            }
+            if (*cur++ != Ch(',')) {
+                return false;
+            }
+        }
+    }
+
+    bool parse_array(proptree_type& node)
+    {
+        ++cur;
+        skip_ws();
+        if (cur != end && *cur == Ch(']')) {
+            ++cur;
+            return true;
+        }
+        while (true) {
+            auto& child{node.push_back(typename proptree_type::value_type{string_type{}, proptree_type{}})->second};
+            if (!parse_value(child)) {
+                return false;
+            }
+            skip_ws();
+            if (cur == end) {
+                return false;
+            }
+            if (*cur == Ch(']')) {
+                ++cur;
+                return true;
+            }
+            if (*cur++ != Ch(',')) {
+                return false;
+            }
+        }
+    }
+
+    // add only the members that are in the projection
+    bool project_object(proptree_type& node, std::size_t field)
+    {
+        ++cur;
+        skip_ws();
+        if (cur != end && *cur == Ch('}')) {
+            ++cur;
+            return true;
+        }
+        string_type key;
+        while (true) {
+            skip_ws();
+            if (cur == end || *cur != Ch('"')) {
+                return false;
+            }
+            ++cur;
+            key.clear();
+            if (!parse_string(key)) {
+                return false;
+            }
+            skip_ws();
+            if (cur == end || *cur != Ch(':')) {
+                return false;
+            }
+            ++cur;
+            const auto member{projection->find(field, key)};
+            if (member == all || !leads_to(member)) {
+                if (!skip_value()) {
+                    return false;
+                }
+            } else {
+                // when the key is repeated we already counted it
+                const bool repeated{node.find(key) != node.not_found()};
+                auto& child{node.push_back(typename proptree_type::value_type{key, proptree_type{}})->second};
+                if (!parse_value(child, projection->at(member).whole ? all : member)) {
+                    return false;
+                }
+                if (found_field(member, repeated)) {
+                    return true;
+                }
+            }
+            skip_ws();
+            if (cur == end) {
+                return false;
+            }
+            if (*cur == Ch('}')) {
+                ++cur;
+                return true;
+            }
+            if (*cur++ != Ch(',')) {
+                return false;
+            }
+        }
+    }
+
+    // the items are added even if they don't match, so they would keep their index
+    bool project_array(proptree_type& node, std::size_t field)
+    {
+        const auto items{projection->at(field).items};
+        if (items == all) {
+            return skip_value();
+        }
+        ++cur;
+        skip_ws();
+        if (cur != end && *cur == Ch(']')) {
+            ++cur;
+            return true;
+        }
+        while (true) {
+            auto& child{node.push_back(typename proptree_type::value_type{string_type{}, proptree_type{}})->second};
+            if (!parse_value(child, projection->at(items).whole ? all : items)) {
+                return false;
+            }
+            skip_ws();
+            if (cur == end) {
+                return false;
+            }
+            if (*cur == Ch(']')) {
+                ++cur;
+                return true;
+            }
+            if (*cur++ != Ch(',')) {
+                return false;
+            }
+        }
+    }
+
+    // false when the next value cannot have the fields that are under this
+    // location, for example a string where we are looking for its members -
+    // it is not added to the tree, as if it was not in the input
+    bool leads_to(std::size_t field)
+    {
+        const auto& at{projection->at(field)};
+        if (at.whole) {
+            return true;
+        }
+        skip_ws();
+        return cur != end && ((*cur == Ch('{') && !at.members.empty()) || (*cur == Ch('[') && at.items != all));
+    }
+
+    // return true when this was the last field that we need
+    bool found_field(std::size_t field, bool repeated)
+    {
+        if (remaining == 0 || repeated || !projection->at(field).whole) {
+            return done;
+        }
+        done = --remaining == 0;
+        return done;
+    }
+
+    // check the value without adding it
+    bool skip_value()
+    {
+        skip_ws();
+        if (cur == end) {
+            return false;
+        }
+        bool integer = true;
+        switch (*cur) {
+        case Ch('{'):
+            return skip_object();
+        case Ch('['):
+            return skip_array();
+        case Ch('"'):
+            ++cur;
+            return skip_string();
+        case Ch('t'):
+            return skip_literal("true");
+        case Ch('f'):
+            return skip_literal("false");
+        case Ch('n'):
+            return skip_literal("null");
+        default:
+            return skip_number(integer);
+        }
+    }
+
+    bool skip_object()
+    {
+        ++cur;
+        skip_ws();
+        if (cur != end && *cur == Ch('}')) {
+            ++cur;
+            return true;
+        }
+        while (true) {
+            skip_ws();
+            if (cur == end || *cur != Ch('"')) {
+                return false;
+            }
+            ++cur;
+            if (!skip_string()) {
+                return false;
+            }
+            skip_ws();
+            if (cur == end || *cur != Ch(':')) {
+                return false;
+            }
+            ++cur;
+            if (!skip_value()) {
+                return false;
+            }
+            skip_ws();
+            if (cur == end) {
+                return false;
+            }
+            if (*cur == Ch('}')) {
+                ++cur;
+                return true;
+            }
+            if (*cur++ != Ch(',')) {
+                return false;
+            }
+        }
+    }
+
+    bool skip_array()
+    {
+        ++cur;
+        skip_ws();
+        if (cur != end && *cur == Ch(']')) {
+            ++cur;
+            return true;
+        }
+        while (true) {
+            if (!skip_value()) {
+                return false;
+            }
+            skip_ws();
+            if (cur == end) {
+                return false;
+            }
+            if (*cur == Ch(']')) {
+                ++cur;
+                return true;
+            }
+            if (*cur++ != Ch(',')) {
+                return false;
+            }
+        }
+    }
+
+    // the same checks as parse_string, only the escapes are
+    // decoded into a buffer that we don't use
+    bool skip_string()
+    {
+        while (true) {
+            if (cur == end) {
+                return false;
+            }
+            const Ch c{*cur};
+            if (c == Ch('"')) {
+                ++cur;
+                return true;
+            }
+            if (c == Ch('\\')) {
+                ++cur;
+                scratch.clear();
+                if (!parse_escape(scratch)) {
+                    return false;
+                }
+            } else if (!skip_code_point()) {
+                return false;
+            }
+        }
+    }
+
+    // we are after the opening quote
+    bool parse_string(string_type& out)
+    {
+        const Ch* run{cur};
+        while (true) {
+            if (cur == end) {
+                return false;
+            }
+            const Ch c{*cur};
+            if (c == Ch('"')) {
+                out.append(run, cur);
+                ++cur;
+                return true;
+            }
+            if (c == Ch('\\')) {
+                out.append(run, cur);
+                ++cur;
+                if (!parse_escape(out)) {
+                    return false;
+                }
+                run = cur;
+            } else if (!skip_code_point()) {
+                return false;
+            }
+        }
+    }
+
+    bool parse_literal(string_type& out, const char* word)
+    {
+        const Ch* from{cur};
+        if (!skip_literal(word)) {
+            return false;
+        }
+        out.assign(from, cur);
+        return true;
+    }
+
+    bool skip_literal(const char* word)
+    {
+        for (const char* w = word; *w; ++w, ++cur) {
+            if (cur == end || *cur != Ch(*w)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parse_number(string_type& out, value_info& info)
+    {
+        const Ch* from{cur};
+        bool integer = true;
+        if (!skip_number(integer)) {
+            return false;
+        }
+        out.assign(from, cur);
+        if (locations) {
+            decode_number(from, integer, info);
+        }
+        return true;
+    }
+
+    bool skip_number(bool& integer)
+    {
+        if (*cur == Ch('-')) {
+            ++cur;
+        }
+        if (cur == end) {
+            return false;
+        }
+        if (*cur == Ch('0')) {
+            ++cur;
+        } else if (*cur >= Ch('1') && *cur <= Ch('9')) {
+            skip_digits();
+        } else {
+            return false;
+        }
+        if (cur != end && *cur == Ch('.')) {
+            integer = false;
+            ++cur;
+            if (cur == end || !is_digit(*cur)) {
+                return false;
+            }
+            skip_digits();
+        }
+        if (cur != end && (*cur == Ch('e') || *cur == Ch('E'))) {
+            integer = false;
+            ++cur;
+            if (cur != end && (*cur == Ch('+') || *cur == Ch('-'))) {
+                ++cur;
+            }
+            if (cur == end || !is_digit(*cur)) {
+                return false;
+            }
+            skip_digits();
+        }
+        return true;
+    }
+
+    // the number between from and the current location is valid
+    void decode_number(const Ch* from, bool integer, value_info& info) const
+    {
+        info.kind = value_kind::real;
+        if (integer) {
+            const bool negative{*from == Ch('-')};
+            std::uint64_t value = 0;
+            bool overflow = false;
+            for (const Ch* d = negative ? from + 1 : from; d != cur && !overflow; ++d) {
+                const auto digit{static_cast<std::uint64_t>(*d - Ch('0'))};
+                overflow = value > (~std::uint64_t{0} - digit) / 10;
+                value = value * 10 + digit;
+            }
+            constexpr auto int_max{static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())};
+            if (!overflow && !negative) {
+                info.decoded = true;
+                if (value <= int_max) {
+                    info.kind = value_kind::integer;
+                    info.value.integer = static_cast<std::int64_t>(value);
+                } else {
+                    info.kind = value_kind::unsigned_integer;
+                    info.value.unsigned_integer = value;
+                }
+                return;
+            }
+            // -0 is kept as real so it would not lose its sign
+            if (!overflow && value > 0 && value <= int_max + 1) {
+                info.decoded = true;
+                info.kind = value_kind::integer;
+                info.value.integer = static_cast<std::int64_t>(0 - value);
+                return;
+            }
+            // too large for integer - we would read it as real
+        }
+        if constexpr (sizeof(Ch) == 1) {
+            info.decoded = std::from_chars(from, cur, info.value.real).ec == std::errc{};
+        } else {
+            // numbers are ASCII, we only need to make them narrow
+            char narrow[64];
+            const auto size{static_cast<std::size_t>(cur - from)};
+            if (size <= sizeof(narrow)) {
+                std::transform(from, cur, narrow, [] (Ch c) { return static_cast<char>(c); });
+                info.decoded = std::from_chars(narrow, narrow + size, info.value.real).ec == std::errc{};
+            }
+        }
+    }
+
+    void skip_digits()
+    {
+        while (cur != end && is_digit(*cur)) {
+            ++cur;
+        }
+    }
+
+    bool parse_escape(string_type& out)
+    {
+        if (cur == end) {
+            return false;
+        }
+        switch (*cur++) {
+        case Ch('"'):
+            out.push_back(Ch('"'));
+            return true;
+        case Ch('\\'):
+            out.push_back(Ch('\\'));
+            return true;
+        case Ch('/'):
+            out.push_back(Ch('/'));
+            return true;
+        case Ch('b'):
+            out.push_back(Ch('\b'));
+            return true;
+        case Ch('f'):
+            out.push_back(Ch('\f'));
+            return true;
+        case Ch('n'):
+            out.push_back(Ch('\n'));
+            return true;
+        case Ch('r'):
+            out.push_back(Ch('\r'));
+            return true;
+        case Ch('t'):
+            out.push_back(Ch('\t'));
+            return true;
+        case Ch('u'):
+            return parse_code_point_ref(out);
+        default:
+            return false;
+        }
+    }
+
+    static bool is_surrogate_high(unsigned code)
+    {
+        return (code & 0xfc00) == 0xd800;
+    }
+
+    static bool is_surrogate_low(unsigned code)
+    {
+        return (code & 0xfc00) == 0xdc00;
+    }
+
+    bool parse_hex_quad(unsigned& code)
+    {
+        code = 0;
+        for (int i = 0; i < 4; ++i, ++cur) {
+            if (cur == end) {
+                return false;
+            }
+            const Ch c{*cur};
+            unsigned digit = 0;
+            if (c >= Ch('0') && c <= Ch('9')) {
+                digit = static_cast<unsigned>(c - Ch('0'));
+            } else if (c >= Ch('a') && c <= Ch('f')) {
+                digit = static_cast<unsigned>(c - Ch('a') + 10);
+            } else if (c >= Ch('A') && c <= Ch('F')) {
+                digit = static_cast<unsigned>(c - Ch('A') + 10);
+            } else {
+                return false;
+            }
+            code = code * 16 + digit;
+        }
+        return true;
+    }
+
+    bool parse_code_point_ref(string_type& out)
+    {
+        unsigned code = 0;
+        if (!parse_hex_quad(code) || is_surrogate_low(code)) {
+            return false;
+        }
+        if (is_surrogate_high(code)) {
+            if (end - cur < 2 || cur[0] != Ch('\\') || cur[1] != Ch('u')) {
+                return false;
+            }
+            cur += 2;
+            unsigned low = 0;
+            if (!parse_hex_quad(low) || !is_surrogate_low(low)) {
+                return false;
+            }
+            code = 0x10000 + (((code & 0x3ff) << 10) | (low & 0x3ff));
+        }
+        append_code_point(out, code);
+        return true;
+    }
+
+    static void append_code_point(string_type& out, unsigned code)
+    {
+        if constexpr (sizeof(Ch) == 1) {
+            if (code <= 0x7f) {
+                out.push_back(static_cast<Ch>(code));
+            } else if (code <= 0x7ff) {
+                out.push_back(static_cast<Ch>(0xc0 | (code >> 6)));
+                out.push_back(static_cast<Ch>(0x80 | (code & 0x3f)));
+            } else if (code <= 0xffff) {
+                out.push_back(static_cast<Ch>(0xe0 | (code >> 12)));
+                out.push_back(static_cast<Ch>(0x80 | ((code >> 6) & 0x3f)));
+                out.push_back(static_cast<Ch>(0x80 | (code & 0x3f)));
+            } else {
+                out.push_back(static_cast<Ch>(0xf0 | (code >> 18)));
+                out.push_back(static_cast<Ch>(0x80 | ((code >> 12) & 0x3f)));
+                out.push_back(static_cast<Ch>(0x80 | ((code >> 6) & 0x3f)));
+                out.push_back(static_cast<Ch>(0x80 | (code & 0x3f)));
+            }
+        } else if constexpr (sizeof(Ch) == 2) {
+            if (code < 0x10000) {
+                out.push_back(static_cast<Ch>(code));
+            } else {
+                code -= 0x10000;
+                out.push_back(static_cast<Ch>((code >> 10) | 0xd800));
+                out.push_back(static_cast<Ch>((code & 0x3ff) | 0xdc00));
+            }
+        } else {
+            out.push_back(static_cast<Ch>(code));
+        }
+    }
+
+    // move over a single code point in a string, and check
+    // that it is valid - the same rules as boost is using
+    bool skip_code_point()
+    {
+        if constexpr (sizeof(Ch) == 1) {
+            const auto c{static_cast<unsigned char>(*cur)};
+            ++cur;
+            if (c <= 0x7f) {
+                return c >= 0x20;
+            }
+            static constexpr signed char trail_table[] = {
+                -1, -1, -1, -1, -1, -1, -1, -1,     // not a lead byte
+                1, 1, 1, 1,                         // 1 trailing byte
+                2, 2,                               // 2 trailing bytes
+                3,                                  // 3 trailing bytes
+                -1                                  // 4 or 5 trailing bytes, not allowed
+            };
+            const int trailing{trail_table[(c & 0x7f) >> 3]};
+            if (trailing < 0) {
+                return false;
+            }
+            for (int i = 0; i < trailing; ++i, ++cur) {
+                if (cur == end || (static_cast<unsigned char>(*cur) & 0xc0) != 0x80) {
+                    return false;
+                }
+            }
+            return true;
+        } else {
+            const Ch c{*cur};
+            ++cur;
+            if (c < 0x20) {
+                return false;
+            }
+            if constexpr (sizeof(Ch) == 2) {
+                if (is_surrogate_low(static_cast<unsigned>(c))) {
+                    return false;
+                }
+                if (is_surrogate_high(static_cast<unsigned>(c))) {
+                    if (cur == end || !is_surrogate_low(static_cast<unsigned>(*cur))) {
+                        return false;
+                    }
+                    ++cur;
+                }
+            }
+            return true;
+        }
+    }
+
+    void skip_ws()
+    {
+        while (cur != end && (*cur == Ch(' ') || *cur == Ch('\t') || *cur == Ch('\n') || *cur == Ch('\r'))) {
+            ++cur;
+        }
+    }
+
+    // skip the byte order mark at the start
+    void skip_introduction()
+    {
+        if constexpr (sizeof(Ch) == 1) {
+            // this is what boost is doing - it is not checking the rest of it
+            if (cur != end && static_cast<unsigned char>(*cur) == 0xef) {
+                for (int i = 0; i < 3 && cur != end; ++i) {
+                    ++cur;
+                }
+            }
+        } else {
+            if (cur != end && static_cast<unsigned>(*cur) == 0xfeff) {
+                ++cur;
+            }
+        }
+    }
+
+private:
+    const Ch* start = nullptr;
+    const Ch* cur = nullptr;
+    const Ch* end = nullptr;
+    locations_type* locations = nullptr;
+    const projection_type* projection = nullptr;
+    std::size_t remaining = 0;      // the fields that we still need to find
+    bool done = false;
+    string_type scratch;
+};
+
+// the types that we can read directly from the decoded value - chars
+// are read as chars and not as numbers so they are not here
+template<typename T>
+constexpr bool is_decoded_type_v = std::is_same_v<T, bool> || std::is_floating_point_v<T> ||
+        (std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, signed char> &&
+         !std::is_same_v<T, unsigned char> && !std::is_same_v<T, wchar_t>);
+
+// read the value that we decoded while parsing into out. Return false when
+// this is not possible (wrong type or out of range) - in this case the value
+// should be read from the text as before, so we would have the same result
+template<typename T>
+bool load_decoded(const value_info& info, T& out)
+{
+    static_assert(is_decoded_type_v<T>, "only numbers and booleans are decoded");
+    if (!info.decoded) {
+        return false;
+    }
+    if constexpr (std::is_same_v<T, bool>) {
+        if (info.kind == value_kind::boolean) {
+            out = info.value.boolean;
+            return true;
+        }
+    } else if constexpr (std::is_integral_v<T>) {
+        if (info.kind == value_kind::integer && std::in_range<T>(info.value.integer)) {
+            out = static_cast<T>(info.value.integer);
+            return true;
+        }
+        if (info.kind == value_kind::unsigned_integer && std::in_range<T>(info.value.unsigned_integer)) {
+            out = static_cast<T>(info.value.unsigned_integer);
+            return true;
+        }
+    } else {
+        if (info.kind == value_kind::integer) {
+            out = static_cast<T>(info.value.integer);
+            return true;
+        }
+        if (info.kind == value_kind::unsigned_integer) {
+            out = static_cast<T>(info.value.unsigned_integer);
+            return true;
+        }
+        // narrowing double would not round the same as reading the text
+        if (info.kind == value_kind::real && std::is_same_v<T, double>) {
+            out = static_cast<T>(info.value.real);
+            return true;
+        }
+    }
+    return false;
+}
+
+// parse the input into the tree - on failure the tree is not changed
+template<typename Ch>
+bool parse_tree(const Ch* from, std::size_t size, typename ptree_type<Ch>::proptree_type& pt)
+{
+    typename ptree_type<Ch>::proptree_type result;
+    tree_parser<Ch> parser{from, from + size};
+    if (!parser.parse(result)) {
+        return false;
+    }
+    pt.swap(result);
+    return true;
+}
+
+// The parsed input, together with the text that it was parsed from, so that we
+// can find the original text of each value in the tree
+template<typename Ch>
+class basic_document
+{
+public:
+    using proptree_type = typename ptree_type<Ch>::proptree_type;
+    using string_type = std::basic_string<Ch>;
+    using view_type = std::basic_string_view<Ch>;
+
+    basic_document() = default;
+
+    basic_document(const basic_document& other) : input{other.input}, tree{other.tree}
+    {
+        copy_locations(other.tree, tree, other);
+        keys.reset(&tree);
+    }
+
+    basic_document& operator = (const basic_document& other)
+    {
+        if (this != &other) {
+            input = other.input;
+            tree = other.tree;
+            locations.clear();
+            copy_locations(other.tree, tree, other);
+            keys.reset(&tree);
+        }
+        return *this;
+    }
+
+    // the children of the tree keep their addresses, only the root is moving,
+    // and the offsets are into the input which is moved with it
+    basic_document(basic_document&& other) : input{std::move(other.input)}
+    {
+        tree.swap(other.tree);
+        locations.take(other.locations, &other.tree, &tree);
+        keys.reset(&tree);
+        other.clear();
+    }
+
+    basic_document& operator = (basic_document&& other)
+    {
+        if (this != &other) {
+            input = std::move(other.input);
+            tree.clear();
+            tree.swap(other.tree);
+            locations.take(other.locations, &other.tree, &tree);
+            keys.reset(&tree);
+            other.clear();
+        }
+        return *this;
+    }
+
+    // when fields is given, only these paths are added to the tree
+    bool parse(string_type text, const basic_projection<Ch>* fields = nullptr)
+    {
+        clear();
+        input = std::move(text);
+        tree_parser<Ch> parser{input.data(), input.data() + input.size(), &locations, fields};
+        if (!parser.parse(tree)) {
+            clear();
+            return false;
+        }
+        keys.reset(&tree);
+        return true;
+    }
+
+    void clear()
+    {
+        tree.clear();
+        locations.clear();
+        keys.reset(nullptr);
+        input.clear();
+    }
+
+    proptree_type& root()
+    {
+        return tree;
+    }
+
+    const proptree_type& root() const
+    {
+        return tree;
+    }
+
+    // the text of the node as it is in the input, or
+    // empty if this node is not from this document
+    view_type text(const proptree_type& node) const
+    {
+        const auto* location{locations.find(&node)};
+        return location ? view_type{input.data() + location->offset, location->size} : view_type{};
+    }
+
+    // what we know about the node from the parsing, or
+    // null if this node is not from this document
+    const value_info* info(const proptree_type& node) const
+    {
+        return locations.find(&node);
+    }
+
+    // the child of the object with this key (the first one, as the tree would
+    // find it), or null if it has none. For the nodes of this document this
+    // is using the index of the keys, other nodes are searched in the tree
+    proptree_type* child(proptree_type& node, view_type key) const
+    {
+        if (locations.find(&node)) {
+            // the index only has const nodes, the node itself is not const
+            return const_cast<proptree_type*>(keys.find(node, key));
+        }
+        const auto found{node.find(typename proptree_type::key_type{key})};
+        return found == node.not_found() ? nullptr : &found->second;
+    }
+
+private:
+    void copy_locations(const proptree_type& from, const proptree_type& to, const basic_document& other)
+    {
+        if (const auto* location{other.locations.find(&from)}) {
+            locations.insert(&to, *location);
+        }
+        auto target{to.begin()};
+        for (const auto& child : from) {
+            copy_locations(child.second, target->second, other);
+            ++target;
+        }
+    }
+
+private:
+    string_type input;
+    proptree_type tree;
+    node_map<proptree_type, value_info> locations;
+    key_index<proptree_type> keys;
+};
+
+}   // end of namespace details
+
+}   // end of namespace json
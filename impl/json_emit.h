@@ -0,0 +1,413 @@
+#pragma once
+#include <boost/property_tree/ptree.hpp>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// This is the code that writes the tree into JSON text. It follows the same
+// rules as the fixed version of boost property tree writer (see boost_fix),
+// i.e. values are written as they are stored in the tree (strings are already
+// quoted when they are added), and only the special chars are escaped.
+// Unlike the boost writer, this is not bound to std::ostream, the output
+// goes into a "sink" - anything that has:
+//  put(Ch)                     - write a single char
+//  write(const Ch*, size_t)    - write a block of chars
+//  fill(Ch, size_t)            - write the same char n times
+// This allow us for example to calculate the exact size of the output
+// before we are writing it.
+namespace json
+{
+
+namespace details
+{
+
+// this sink only count the number of chars that would be written
+template<typename Ch>
+struct counting_sink
+{
+    void put(Ch)
+    {
+        ++count;
+    }
+
+    void write(const Ch*, std::size_t n)
+    {
+        count += n;
+    }
+
+    void fill(Ch, std::size_t n)
+    {
+        count += n;
+    }
+
+    std::size_t count = 0;
+};
+
+// add the output to the end of a string
+template<typename Ch>
+struct append_sink
+{
+    explicit append_sink(std::basic_string<Ch>& s) : to{s}
+    {
+    }
+
+    void put(Ch c)
+    {
+        to.push_back(c);
+    }
+
+    void write(const Ch* from, std::size_t n)
+    {
+        to.append(from, n);
+    }
+
+    void fill(Ch c, std::size_t n)
+    {
+        to.append(n, c);
+    }
+
+    std::basic_string<Ch>& to;
+};
+
+// write into memory that is known to be large enough to hold the output
+template<typename Ch>
+struct buffer_sink
+{
+    explicit buffer_sink(Ch* start) : at{start}
+    {
+    }
+
+    void put(Ch c)
+    {
+        *at++ = c;
+    }
+
+    void write(const Ch* from, std::size_t n)
+    {
+        std::char_traits<Ch>::copy(at, from, n);
+        at += n;
+    }
+
+    void fill(Ch c, std::size_t n)
+    {
+        std::char_traits<Ch>::assign(at, n, c);
+        at += n;
+    }
+
+    Ch* at = nullptr;
+};
+
+// write to a standard stream, we are going directly to the stream
+// buffer so we would not pay for the sentry on each write
+template<typename Ch>
+struct stream_sink
+{
+    explicit stream_sink(std::basic_ostream<Ch>& s) : stream{s}, buffer{s.rdbuf()}
+    {
+    }
+
+    void put(Ch c)
+    {
+        if (buffer->sputc(c) == std::char_traits<Ch>::eof()) {
+            stream.setstate(std::ios_base::badbit);
+        }
+    }
+
+    void write(const Ch* from, std::size_t n)
+    {
+        if (buffer->sputn(from, static_cast<std::streamsize>(n)) != static_cast<std::streamsize>(n)) {
+            stream.setstate(std::ios_base::badbit);
+        }
+    }
+
+    void fill(Ch c, std::size_t n)
+    {
+        while (n-- > 0) {
+            put(c);
+        }
+    }
+
+    std::basic_ostream<Ch>& stream;
+    std::basic_streambuf<Ch>* buffer;
+};
+
+template<typename Ch>
+constexpr bool is_escape_free(Ch cha)
+{
+    // the same as the check in the writer fix - note that for signed
+    // char everything above 0x7f is not passing this test, but it is written
+    // as is anyway
+    return (cha == 0x20 || cha == 0x21 || (cha >= 0x23 && cha <= 0x2E) ||
+                (cha >= 0x30 && cha <= 0x5B) || (cha >= 0x5D));
+}
+
+template<typename Ch>
+constexpr bool is_hex_digit(Ch c)
+{
+    return (c >= Ch('0') && c <= Ch('9')) || (c >= Ch('a') && c <= Ch('f')) || (c >= Ch('A') && c <= Ch('F'));
+}
+
+// true when the backslash at the given location is the start of a unicode
+// escape (\uXXXX) that we need to keep as is
+template<typename Ch>
+bool is_unicode_escape(const Ch* at, const Ch* end, Ch first_char)
+{
+    if (at + 1 == end || at[1] != Ch('u')) {
+        return false;
+    }
+    at += 2;
+    while (at != end && is_hex_digit(*at)) {
+        ++at;
+    }
+    return at == end || *at == first_char;
+}
+
+template<typename Ch, typename Sink>
+void write_escape(Sink& sink, Ch c)
+{
+    sink.put(Ch('\\'));
+    sink.put(c);
+}
+
+// write a part [from, to) of the value [start, end) into the sink, and escape
+// the special chars in it. Note that the value may be already quoted, in this
+// case the first and last quotes are not escaped
+template<typename Ch, typename Sink>
+void write_escaped(Sink& sink, const Ch* start, const Ch* end, const Ch* from, const Ch* to)
+{
+    if (from == to) {
+        return;
+    }
+    const Ch* last = end - 1;
+    const Ch first_char = *start;
+    while (from != to) {
+        const Ch* run = from;
+        while (from != to && is_escape_free(*from)) {
+            ++from;
+        }
+        if (from != run) {
+            sink.write(run, static_cast<std::size_t>(from - run));
+            if (from == to) {
+                return;
+            }
+        }
+        switch (*from) {
+        case Ch('\b'):
+            write_escape(sink, Ch('b'));
+            break;
+        case Ch('\f'):
+            write_escape(sink, Ch('f'));
+            break;
+        case Ch('\n'):
+            write_escape(sink, Ch('n'));
+            break;
+        case Ch('\r'):
+            write_escape(sink, Ch('r'));
+            break;
+        case Ch('\t'):
+            write_escape(sink, Ch('t'));
+            break;
+        case Ch('\\'):
+            if (is_unicode_escape(from, end, first_char)) {
+                sink.put(Ch('\\'));
+            } else {
+                write_escape(sink, Ch('\\'));
+            }
+            break;
+        case Ch('"'):
+            if (from != start && from != last) {
+                sink.put(Ch('\\'));
+            }
+            sink.put(Ch('"'));
+            break;
+        default:
+            sink.put(*from);
+            break;
+        }
+        ++from;
+    }
+}
+
+template<typename Ch, typename Sink>
+void write_escaped(Sink& sink, const Ch* from, const Ch* end)
+{
+    write_escaped(sink, from, end, from, end);
+}
+
+template<typename Ch, typename Sink>
+void write_escaped(Sink& sink, const std::basic_string<Ch>& str)
+{
+    write_escaped(sink, str.data(), str.data() + str.size());
+}
+
+// Values that are already formatted as JSON, and are written as they are,
+// without going over them to escape them (see sub_tree). The data of such
+// a node is this marker followed by the text of the value. For the narrow
+// tree the marker is a byte that is never part of valid UTF-8, and for the
+// wide tree a low surrogate with no high surrogate before it. The parsers
+// reject both, and the output stream is storing strings quoted, so no value
+// that we read or add to the tree can be taken for such a value
+template<typename Ch>
+constexpr Ch raw_marker = static_cast<Ch>(0xdfff);
+
+template<>
+constexpr char raw_marker<char> = static_cast<char>(0xff);
+
+template<typename Ch>
+bool is_raw_value(const std::basic_string<Ch>& data)
+{
+    return !data.empty() && data.front() == raw_marker<Ch>;
+}
+
+template<typename Ch>
+std::basic_string<Ch> make_raw_value(std::basic_string_view<Ch> text)
+{
+    std::basic_string<Ch> data;
+    data.reserve(text.size() + 1);
+    data.push_back(raw_marker<Ch>);
+    data.append(text);
+    return data;
+}
+
+// the text that is written for raw value (see is_raw_value)
+template<typename Ch>
+std::basic_string_view<Ch> raw_text(const std::basic_string<Ch>& data)
+{
+    return {data.data() + 1, data.size() - 1};
+}
+
+template<typename Ptree>
+bool is_array_node(const Ptree& pt)
+{
+    for (const auto& child : pt) {
+        if (!child.first.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Verify if ptree does not contain information that cannot be written to json
+template<typename Ptree>
+bool verify_tree(const Ptree& pt, int depth)
+{
+    if (!pt.data().empty() && (!pt.empty() || (depth == 0 && !is_raw_value(pt.data())))) {
+        return false;
+    }
+    for (const auto& child : pt) {
+        if (!verify_tree(child.second, depth + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Ptree, typename Sink>
+void write_tree(Sink& sink, const Ptree& pt, int indent, bool pretty)
+{
+    using Ch = typename Ptree::key_type::value_type;
+
+    const auto spaces = [&sink, pretty] (int level) {
+        if (pretty) {
+            sink.fill(Ch(' '), static_cast<std::size_t>(4 * level));
+        }
+    };
+    const auto new_line = [&sink, pretty] () {
+        if (pretty) {
+            sink.put(Ch('\n'));
+        }
+    };
+
+    if (pt.empty() && is_raw_value(pt.data())) {
+        const auto text{raw_text(pt.data())};
+        sink.write(text.data(), text.size());
+    } else if (indent > 0 && pt.empty()) {
+        write_escaped(sink, pt.data());
+    } else if (is_array_node(pt)) {
+        sink.put(Ch('['));
+        new_line();
+        for (auto it = pt.begin(); it != pt.end();) {
+            spaces(indent + 1);
+            write_tree(sink, it->second, indent + 1, pretty);
+            if (++it != pt.end()) {
+                sink.put(Ch(','));
+            }
+            new_line();
+        }
+        spaces(indent);
+        sink.put(Ch(']'));
+    } else {
+        sink.put(Ch('{'));
+        new_line();
+        for (auto it = pt.begin(); it != pt.end();) {
+            spaces(indent + 1);
+            sink.put(Ch('"'));
+            write_escaped(sink, it->first);
+            sink.put(Ch('"'));
+            sink.put(Ch(':'));
+            if (pretty) {
+                sink.put(Ch(' '));
+            }
+            write_tree(sink, it->second, indent + 1, pretty);
+            if (++it != pt.end()) {
+                sink.put(Ch(','));
+            }
+            new_line();
+        }
+        spaces(indent);
+        sink.put(Ch('}'));
+    }
+}
+
+// write the complete document - this is the same as the boost write_json
+template<typename Ptree, typename Sink>
+bool write_document(Sink& sink, const Ptree& pt, bool pretty)
+{
+    using Ch = typename Ptree::key_type::value_type;
+
+    if (!verify_tree(pt, 0)) {
+        return false;
+    }
+    write_tree(sink, pt, 0, pretty);
+    sink.put(Ch('\n'));
+    return true;
+}
+
+// the exact number of chars that write_document would generate,
+// or nothing if this tree cannot be written as JSON
+template<typename Ptree>
+std::size_t document_size(const Ptree& pt, bool pretty)
+{
+    counting_sink<typename Ptree::key_type::value_type> counter;
+    return write_document(counter, pt, pretty) ? counter.count : 0;
+}
+
+// write into pre-allocated memory, that must be at least the size
+// returned from document_size
+template<typename Ptree>
+std::size_t write_into_buffer(typename Ptree::key_type::value_type* to, const Ptree& pt, bool pretty)
+{
+    buffer_sink<typename Ptree::key_type::value_type> sink{to};
+    write_tree(sink, pt, 0, pretty);
+    sink.put(typename Ptree::key_type::value_type('\n'));
+    return static_cast<std::size_t>(sink.at - to);
+}
+
+// write into a string, that would be resized to hold the exact size of the output
+// this is the two passes writing - first calculate the size, then write. The
+// values in the tree are already formatted, so the first pass is only a scan
+template<typename Ptree>
+std::size_t write_into_string(std::basic_string<typename Ptree::key_type::value_type>& to, const Ptree& pt, bool pretty)
+{
+    const auto size = document_size(pt, pretty);
+    to.resize(size);
+    if (size > 0) {
+        write_into_buffer(to.data(), pt, pretty);
+    }
+    return size;
+}
+
+}   // end of namespace details
+
+}   // end of namespace json
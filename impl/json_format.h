@@ -0,0 +1,112 @@
+#pragma once
+#include <charconv>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace json
+{
+
+namespace details
+{
+
+// scalar types that we can format directly as JSON text, without going
+// through the property tree string translator for each of them.
+// note that the character types are excluded, since the tree is writing
+// them as characters and not as numbers
+template<typename T>
+struct is_native_number
+{
+    using type = std::remove_cv_t<T>;
+    static constexpr bool value = std::is_arithmetic_v<type> &&
+        !std::is_same_v<type, char> && !std::is_same_v<type, signed char> &&
+        !std::is_same_v<type, unsigned char> && !std::is_same_v<type, wchar_t> &&
+        !std::is_same_v<type, char8_t> && !std::is_same_v<type, char16_t> &&
+        !std::is_same_v<type, char32_t>;
+};
+
+template<typename T>
+constexpr bool is_native_number_v = is_native_number<T>::value;
+
+// the largest number of chars that format_number would generate for T
+template<typename T>
+constexpr std::size_t max_number_chars()
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        return 5;   // "false"
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return 32;
+    } else {
+        return std::numeric_limits<T>::digits10 + 3;
+    }
+}
+
+// format a single number into the buffer, return the location one
+// past the last char written. The buffer must have at least
+// max_number_chars<T>() chars in it.
+// The text is the same as the tree translator is writing (a stream with
+// boolalpha, and with the precision of max_digits10 for floating points),
+// so the output does not depend on which of them was used for the value
+template<typename T> inline
+char* format_number(char* at, T val)
+{
+    if constexpr (std::is_same_v<T, bool>) {
+        if (val) {
+            std::memcpy(at, "true", 4);
+            return at + 4;
+        }
+        std::memcpy(at, "false", 5);
+        return at + 5;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return std::to_chars(at, at + max_number_chars<T>(), val, std::chars_format::general,
+                    std::numeric_limits<T>::max_digits10).ptr;
+    } else {
+        return std::to_chars(at, at + max_number_chars<T>(), val).ptr;
+    }
+}
+
+template<typename Ch> inline
+void append_ascii(std::basic_string<Ch>& to, const char* from, const char* end)
+{
+    if constexpr (std::is_same_v<Ch, char>) {
+        to.append(from, end);
+    } else {
+        while (from != end) {
+            to.push_back(static_cast<Ch>(*from));
+            ++from;
+        }
+    }
+}
+
+// write a range of numbers as a JSON array - i.e. [1,2,3] into the output
+// this is done in a single loop over the range, with no intermediate
+// nodes or strings for each of the entries
+template<typename Ch, typename Iter, typename Sent = Iter> inline
+void append_array(std::basic_string<Ch>& to, Iter from, Sent end)
+{
+    using value_type = std::iter_value_t<Iter>;
+    static_assert(is_native_number_v<value_type>, "only numbers can be written directly as array");
+
+    if constexpr (std::forward_iterator<Iter>) {
+        // a rough estimation, this would save most of the re-allocations
+        to.reserve(to.size() + static_cast<std::size_t>(std::ranges::distance(from, end)) * 4 + 2);
+    }
+    char buffer[max_number_chars<value_type>() + 1];
+    to.push_back(Ch('['));
+    if (from != end) {
+        append_ascii(to, buffer, format_number<value_type>(buffer, *from));
+        ++from;
+        buffer[0] = ',';
+        while (from != end) {
+            append_ascii(to, buffer, format_number<value_type>(buffer + 1, *from));
+            ++from;
+        }
+    }
+    to.push_back(Ch(']'));
+}
+
+}   // end of namespace details
+
+}   // end of namespace json
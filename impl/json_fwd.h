@@ -14,6 +14,15 @@ struct basic_output_stream;
 template<typename Ch>
 class basic_istream_root;
 
+template<typename Ch>
+class basic_output_stream_pool;
+
+template<typename Ch>
+struct basic_raw_view;
+
+template<typename Ch>
+class basic_projection;
+
 // aliases
 using istream = basic_istream<char>;
 using wistream = basic_istream<wchar_t>;
@@ -21,8 +30,14 @@ using ostream = basic_ostream<char>;
 using wostream = basic_ostream<wchar_t>;
 using output_stream = basic_output_stream<char>;
 using woutput_stream = basic_output_stream<wchar_t>;
+using output_stream_pool = basic_output_stream_pool<char>;
+using woutput_stream_pool = basic_output_stream_pool<wchar_t>;
 using istream_root = basic_istream_root<char>;
 using wistream_root = basic_istream_root<wchar_t>;
+using raw_view = basic_raw_view<char>;
+using wraw_view = basic_raw_view<wchar_t>;
+using projection = basic_projection<char>;
+using wprojection = basic_projection<wchar_t>;
 
 }   // end of namespace json
 
@@ -1,18 +1,26 @@
 #pragma once
 #include "json_stream.h"
 #include "json_reader.h"
+#include "json_document.h"
+#include "json_timing.h"
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/static_assert.hpp>
 #include <optional>
+#include <type_traits>
 #include <filesystem>
 #include <vector>
 #include <list>
 #include <set>
 #include <fstream>
+#include <iterator>
 #include <unordered_set>
 #include <iostream>
+#include <ranges>
+#include <stdexcept>
 
 namespace json
 {
@@ -41,6 +49,29 @@ static const struct __Container {} _container = __Container();
 
 template<typename Ch>
 class basic_istream_root;
+
+template<typename T, typename Ch>
+class basic_array_view;
+
+// The text of a value as it is in the input - an object, an array or a single
+// value (strings are with their quotes). Use it to forward a part of the
+// message without reading it into C++ types and writing it again:
+//  json::raw_view payload;
+//  js ^ "payload"_n ^ payload;
+//  out ^ json::_name("payload") ^ json::sub_tree_ref(payload.text);
+// The text is valid as long as the istream_root that read the input
+// is valid, and it is only available for input that was read by it
+template<typename Ch>
+struct basic_raw_view
+{
+    std::basic_string_view<Ch> text;
+
+    bool empty() const
+    {
+        return text.empty();
+    }
+};
+
 // this class is the class we are using in order to construct 
 // JSON message - in this case we are passing to the it
 // so data that we want to extract and it would extract it from
@@ -53,6 +84,7 @@ struct basic_istream : json_stream
 {
     using proptree_type = typename ptree_type<Ch>::proptree_type;
     using char_type = typename ptree_type<Ch>::char_type;
+    using document_type = details::basic_document<Ch>;
 
     friend class basic_istream_root<Ch>;
 
@@ -62,6 +94,11 @@ struct basic_istream : json_stream
     basic_istream(proptree_type& p, bool stat) : json_stream{stat}, pt(p)
     {
     }
+    // doc is the input that the tree was read from
+    basic_istream(proptree_type& p, const document_type* doc, bool stat = true) :
+            json_stream{stat}, pt(p), document{doc}
+    {
+    }
 
     basic_istream() = delete;
     basic_istream(const basic_istream&) = default;
@@ -112,6 +149,14 @@ struct basic_istream : json_stream
         return this->extract<std::string>(val);
     }
 
+    // read a string without copying it - the view is into the message
+    // that the istream_root read, and it is valid as long as the root
+    // is valid (and is not used to read another message)
+    basic_istream& operator ^ (std::basic_string_view<Ch>& val)
+    {
+        return this->extract_view(val);
+    }
+
     // add support for some build in types that 
     // we can support as well (note that this require cast)
     basic_istream& operator ^ (short& val)
@@ -186,6 +231,12 @@ struct basic_istream : json_stream
         return this->extract<std::string>(val);
     }
 
+    basic_istream& operator ^ (std::optional<std::basic_string_view<Ch>>& val)
+    {
+        this->set_op(true);
+        return this->extract_view(val);
+    }
+
     // add support for some build in types that 
     // we can support as well (note that this require cast)
     basic_istream& operator ^ (std::optional<short>& val)
@@ -264,7 +315,74 @@ struct basic_istream : json_stream
 
     basic_istream get_child(const _name& v) const
     {
-        return basic_istream(pt.get_child(v.value));
+        if (document && is_key(v.value)) {
+            const auto key{key_of(v.value)};
+            if (auto* child{document->child(pt, key)}) {
+                return basic_istream(*child, document);
+            }
+        }
+        return basic_istream(pt.get_child(key_of(v.value)), document);
+    }
+
+    // the text of a value as it is in the input - either the value with the
+    // given name, or if there is no name, the value of this stream
+    basic_istream& operator ^ (basic_raw_view<Ch>& view)
+    {
+        if (this->good()) {
+            const proptree_type* node{this->element_name() ? find_child(this->element_name()) : &pt};
+            view.text = node ? input_text(*node) : std::basic_string_view<Ch>{};
+            if (view.empty() && !this->is_op()) {
+                this->set_state(false);
+            }
+        }
+        this->reset();
+        return *this;
+    }
+
+    // the type of the value as it was in the input - either the value with
+    // the given name, or if there is no name, the value of this stream.
+    // This is only available for input that was read by istream_root
+    basic_istream& operator ^ (value_kind& kind)
+    {
+        if (this->good()) {
+            const proptree_type* node{this->element_name() ? find_child(this->element_name()) : &pt};
+            const auto* info{node && document ? document->info(*node) : nullptr};
+            if (info) {
+                kind = info->kind;
+            } else if (!this->is_op()) {
+                this->set_state(false);
+            }
+        }
+        this->reset();
+        return *this;
+    }
+
+    // the text of this stream value in the input, this is empty
+    // when the input was not read with istream_root
+    std::basic_string_view<Ch> input_text() const
+    {
+        return input_text(pt);
+    }
+
+    const document_type* source_document() const
+    {
+        return document;
+    }
+
+    // the items of this array as T, they are read only when they are used
+    // (see basic_array_view), so you can take a few of them:
+    //  for (int id : js.items<int>("ids"_n) | std::views::take(10)) ...
+    template<typename T>
+    basic_array_view<T, Ch> items() const
+    {
+        return basic_array_view<T, Ch>{pt, document};
+    }
+
+    // throw ptree_bad_path when there is no value with this name
+    template<typename T>
+    basic_array_view<T, Ch> items(const _name& v) const
+    {
+        return basic_array_view<T, Ch>{pt.get_child(key_of(v.value)), document};
     }
 
     proptree_type& entries()
@@ -301,8 +419,11 @@ private:
     {
         BOOST_STATIC_ASSERT(details::check_legal_value<T>::value);
         if (this->good() && this->element_name()) {
-            ref_single_entry<T> i(this->element_name(), val);
-            bool st = i.read(pt);
+            bool st = load_decoded(this->element_name(), val);
+            if (!st) {
+                ref_single_entry<T, Ch> i(key_of(this->element_name()), val);
+                st = i.read(pt);
+            }
             if (!this->is_op()) {   // only if this should be mandatory value, if not then ignore fail to read
                 this->set_state(st);
             }
@@ -317,8 +438,14 @@ private:
         this->set_op(true);
         BOOST_STATIC_ASSERT(details::check_legal_value<T>::value);
         if (this->good() && this->element_name()) {
-            opt_single_entry<T> i(this->element_name(), val);
-            bool st = i.read(pt);
+            T decoded{};
+            bool st = load_decoded(this->element_name(), decoded);
+            if (st) {
+                val = decoded;
+            } else {
+                opt_single_entry<T, Ch> i(key_of(this->element_name()), val);
+                st = i.read(pt);
+            }
             if (!this->is_op()) {   // only if this should be mandatory value, if not then ignore fail to read
                 this->set_state(st);
             }
@@ -327,6 +454,43 @@ private:
         return *this;
     }
 
+    // numbers and booleans were decoded when we parsed the input, so we
+    // can use them without reading the text again
+    template<typename T>
+    bool load_decoded(const char* name, T& val) const
+    {
+        if constexpr (details::is_decoded_type_v<T>) {
+            if (document) {
+                if (const proptree_type* node{find_child(name)}) {
+                    if (const auto* info{document->info(*node)}) {
+                        return details::load_decoded(*info, val);
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // the tree holds the strings after we removed the escapes from
+    // them, so we can point to them directly
+    template<typename T>
+    basic_istream& extract_view(T& val)
+    {
+        if (this->good() && this->element_name()) {
+            const proptree_type* node{find_child(this->element_name())};
+            if (node) {
+                val = std::basic_string_view<Ch>{node->data()};
+            } else if constexpr (!std::is_same_v<T, std::basic_string_view<Ch>>) {
+                val = std::nullopt;
+            }
+            if (!this->is_op()) {   // only if this should be mandatory value, if not then ignore fail to read
+                this->set_state(node != nullptr);
+            }
+        }
+        this->reset();
+        return *this;
+    }
+
     template<typename T>
     basic_istream& extract_elem(T& val, typename proptree_type::value_type& entry)
     {
@@ -342,11 +506,135 @@ private:
         return *this;
     }
 
+    std::basic_string_view<Ch> input_text(const proptree_type& node) const
+    {
+        return document ? document->text(node) : std::basic_string_view<Ch>{};
+    }
+
+    // the names are always narrow, for the wide version we need to convert them
+    static auto key_of(const char* name)
+    {
+        if constexpr (std::is_same_v<Ch, char>) {
+            return name;
+        } else {
+            return widen_str(name);
+        }
+    }
+
+    // the tree is taking a name with '.' in it as a path,
+    // and an empty name as the node itself
+    static bool is_key(const char* name)
+    {
+        return *name && std::strchr(name, '.') == nullptr;
+    }
+
+    proptree_type* find_child(const char* name) const
+    {
+        if (document && is_key(name)) {
+            const auto key{key_of(name)};
+            return document->child(pt, key);
+        }
+        auto child{pt.get_child_optional(key_of(name))};
+        return child ? &child.get() : nullptr;
+    }
+
 private:
     proptree_type& pt;
     bool           array_entries = false;
+    const document_type* document = nullptr;
 };
 
+// A view of the items of an array in the message as T. An item is read from
+// the tree each time it is used (as operator ^ for std::vector<T> does), so
+// nothing is copied in advance - with std::views::filter and std::views::take
+// only the items that are used are read. Reading an item that is not a valid
+// T throws std::runtime_error. The view is valid as long as the tree is.
+template<typename T, typename Ch>
+class basic_array_view : public std::ranges::view_interface<basic_array_view<T, Ch>>
+{
+public:
+    using proptree_type = typename ptree_type<Ch>::proptree_type;
+    using document_type = details::basic_document<Ch>;
+
+    class iterator
+    {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        iterator(typename proptree_type::iterator at, const document_type* doc) : current{at}, document{doc}
+        {
+        }
+
+        T operator * () const
+        {
+            basic_istream<Ch> item{current->second, document};
+            T value{};
+            item ^ _name("") ^ value;
+            if (!item) {
+                throw std::runtime_error{"failed to read array item"};
+            }
+            return value;
+        }
+
+        iterator& operator ++ ()
+        {
+            ++current;
+            return *this;
+        }
+
+        iterator operator ++ (int)
+        {
+            auto old{*this};
+            ++current;
+            return old;
+        }
+
+        bool operator == (const iterator& other) const
+        {
+            return current == other.current;
+        }
+
+    private:
+        typename proptree_type::iterator current{};
+        const document_type* document = nullptr;
+    };
+
+    basic_array_view() = default;
+
+    basic_array_view(proptree_type& array, const document_type* doc) : node{&array}, document{doc}
+    {
+    }
+
+    iterator begin() const
+    {
+        return node ? iterator{node->begin(), document} : iterator{};
+    }
+
+    iterator end() const
+    {
+        return node ? iterator{node->end(), document} : iterator{};
+    }
+
+    std::size_t size() const
+    {
+        return node ? node->size() : 0;
+    }
+
+private:
+    proptree_type* node = nullptr;
+    const document_type* document = nullptr;
+};
+
+template<typename T>
+using array_view = basic_array_view<T, char>;
+template<typename T>
+using warray_view = basic_array_view<T, wchar_t>;
+
 struct __root {};
 constexpr __root _root = __root{};
 
@@ -363,7 +651,7 @@ public:
     using proptree_type = typename stream_type::proptree_type;
     using boolean_type = bool(basic_istream_root<Ch>::*)()const;
 
-    basic_istream_root() : state{false}, tree_root{}
+    basic_istream_root() : state{false}
     {
     }
 
@@ -390,21 +678,62 @@ public:
     }
     
 
+    // the input is kept by the root, so that the values
+    // can refer to it (see basic_raw_view)
+    // The input is UTF-8, for the wide version it is converted to wchar_t
     bool open(const std::string& input)
     {
-        state = read(input, tree_root);
+        timing::scoped_timer timer{timing::phase::open};
+        if constexpr (std::is_same_v<Ch, char>) {
+            state = document.parse(input);
+        } else {
+            state = document.parse(widen_str(input));
+        }
         return state;
     }
 
-    bool open(std::istream& source)
+    bool open(std::string&& input)
     {
-        state = read(source, tree_root);
+        timing::scoped_timer timer{timing::phase::open};
+        if constexpr (std::is_same_v<Ch, char>) {
+            state = document.parse(std::move(input));
+        } else {
+            state = document.parse(widen_str(input));
+        }
         return state;
     }
 
+    // only the paths in fields are read, see basic_projection
+    bool open(const std::string& input, const basic_projection<Ch>& fields)
+    {
+        timing::scoped_timer timer{timing::phase::open};
+        if constexpr (std::is_same_v<Ch, char>) {
+            state = document.parse(input, &fields);
+        } else {
+            state = document.parse(widen_str(input), &fields);
+        }
+        return state;
+    }
+
+    bool open(std::string&& input, const basic_projection<Ch>& fields)
+    {
+        timing::scoped_timer timer{timing::phase::open};
+        if constexpr (std::is_same_v<Ch, char>) {
+            state = document.parse(std::move(input), &fields);
+        } else {
+            state = document.parse(widen_str(input), &fields);
+        }
+        return state;
+    }
+
+    bool open(std::istream& source)
+    {
+        return open(std::string{std::istreambuf_iterator<char>{source}, std::istreambuf_iterator<char>{}});
+    }
+
     bool open(const std::filesystem::path& file_path)
     {
-        std::basic_ifstream<Ch> read_open(file_path.string());
+        std::ifstream read_open(file_path, std::ios::binary);
         if (read_open) {
             return open(read_open);
         } else {
@@ -416,7 +745,7 @@ public:
     stream_type operator ^ (__root)
     {
         if (good()) {
-            return stream_type{tree_root};
+            return stream_type{document.root(), &document};
         } else {
             throw std::runtime_error{"cannot start - no valid state"};
         }
@@ -434,7 +763,7 @@ public:
 
 private:
     bool state = false;
-    proptree_type tree_root;
+    details::basic_document<Ch> document;
 };
 
 using istream_root = basic_istream_root<char>;
@@ -477,7 +806,7 @@ inline basic_istream<T> __child<T>::get()// const
         return stream.get_child(n);
     } catch (const std::exception& e) {
         if (stream.is_op()) {
-            return basic_istream<T>{this->stream.entries(), false};
+            return basic_istream<T>{this->stream.entries(), this->stream.source_document(), false};
         } else {
             throw e;
         }
@@ -502,7 +831,7 @@ struct collection_extractor
         using value_type = typename T::value_type;
         try {
             for (auto i = jis.entries().begin(); i != jis.entries().end(); i++) {
-                basic_istream<Ch> tmp(i->second);
+                basic_istream<Ch> tmp(i->second, jis.source_document());
                 value_type new_value = value_type();
                 tmp ^ _name("") ^ new_value;
                 if (tmp) {
@@ -593,3 +922,6 @@ inline basic_istream<Ch>& operator ^ (basic_istream<Ch>& jis, std::optional<std:
 
 }   // end of namespace json
 
+// the view is only referring to the tree, so its iterators are valid after it is gone
+template<typename T, typename Ch>
+inline constexpr bool std::ranges::enable_borrowed_range<json::basic_array_view<T, Ch>> = true;
@@ -0,0 +1,111 @@
+#pragma once
+#include "json_emit.h"
+#include "json_ostream.h"
+#include "json_sink.h"
+#include <string>
+
+namespace json
+{
+
+// Write records as JSON lines (NDJSON) - each record is written as a single
+// line of compact JSON. The records can be of any type that has
+// operator ^ for json::ostream:
+//  json::fd_sink out{fd};
+//  json::ndjson_writer writer{out};
+//  for (const auto& r : records) {
+//      writer.write(r);
+//  }
+//  writer.flush();
+// The message that is used to build the records and the output buffer are
+// reused for all the records, but the nodes of the tree are allocated again
+// for each record - the property tree cannot keep them once it is cleared.
+// The output is passed to the sink in large blocks. When the sink does not
+// take a block, the records are kept and passed again on the next call to
+// write or flush, and no more records are added until it takes them
+template<output_sink Sink>
+class ndjson_writer
+{
+public:
+    using char_type = typename Sink::char_type;
+
+    static constexpr std::size_t default_block_size = 64 * 1024;
+
+    explicit ndjson_writer(Sink& s, std::size_t block = default_block_size) : sink{s}, block_size{block}
+    {
+        buffer.reserve(block_size);
+    }
+
+    ndjson_writer(const ndjson_writer&) = delete;
+    ndjson_writer& operator = (const ndjson_writer&) = delete;
+
+    ~ndjson_writer()
+    {
+        flush();
+    }
+
+    // add a single record, return false if the record was not added - it
+    // cannot be written as JSON, or the sink is not taking the records that
+    // we already have
+    template<typename T>
+    bool write(const T& record)
+    {
+        if (buffer.size() >= block_size && !write_block()) {
+            return false;
+        }
+        message.clear();
+        auto js{message ^ open};
+        js ^ record;
+        const auto start{buffer.size()};
+        details::append_sink<char_type> out{buffer};
+        if (!details::write_document(out, message.tree_root, false)) {
+            buffer.resize(start);
+            return false;
+        }
+        ++records;
+        if (buffer.size() >= block_size) {
+            write_block();  // if the sink is not taking it, we try again on the next call
+        }
+        return true;
+    }
+
+    template<typename T>
+    ndjson_writer& operator << (const T& record)
+    {
+        write(record);
+        return *this;
+    }
+
+    // pass everything that was written so far to the sink
+    bool flush()
+    {
+        return write_block() && sink.flush();
+    }
+
+    // the number of records that were written
+    std::size_t count() const
+    {
+        return records;
+    }
+
+private:
+    bool write_block()
+    {
+        if (buffer.empty()) {
+            return true;
+        }
+        if (!sink.write(buffer.data(), buffer.size())) {
+            return false;
+        }
+        buffer.clear();
+        return true;
+    }
+
+private:
+    Sink& sink;
+    std::size_t block_size = default_block_size;
+    basic_output_stream<char_type> message;
+    std::basic_string<char_type> buffer;
+    std::size_t records = 0;
+};
+
+}   // end of namespace json
@@ -1,6 +1,8 @@
 #pragma once
 #include "json_stream.h"
 #include "json_base.h"
+#include "json_format.h"
+#include "json_emit.h"
 #include <boost/array.hpp>	// this become part of c++11
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -13,10 +15,17 @@
 #include <list>
 #include <set>
 #include <array>
+#include <algorithm>
+#include <exception>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <optional>
+#include <ranges>
+#include <thread>
 #include <type_traits>
 #include <unordered_set>
+#include <utility>
 
 namespace json
 {
@@ -200,12 +209,41 @@ struct handle_pointer;
 // struct is_stl_container
 //  : detail::is_stl_container<T> {};
 
+// opt in for writing large arrays using multiple threads:
+//  js ^ json::parallel(items);       // use all the cores
+//  js ^ json::parallel(items, 4);    // use 4 threads
+// The array is split between the threads, and each of them is building
+// the nodes of its part with operator ^ of the items. The nodes are then
+// moved into the array in their original order, so the output is the same
+// as the output of js ^ items
+template<typename R>
+struct parallel_range
+{
+    const R& range;
+    unsigned int threads = 0;
+};
+
+template<typename R> inline
+parallel_range<R> parallel(const R& range, unsigned int threads = 0)
+{
+    return parallel_range<R>{range, threads};
+}
+
 template <typename T>
 concept Container = requires(T t) {
     std::begin(t);
     std::end(t);
 };
 
+namespace details
+{
+
+// ranges that we are writing as a single string and not as array
+template<typename R, typename Ch>
+concept text_range = std::is_convertible_v<const R&, std::basic_string_view<Ch>>;
+
+}   // end of namespace details
+
 template<typename Ch>
 struct basic_ostream : json_stream
 {
@@ -299,6 +337,11 @@ struct basic_ostream : json_stream
     	return this->insert<sub_tree>(st);
 	}
 
+    this_type& operator ^ (const sub_tree_ref& st)
+    {
+        return this->insert<sub_tree_ref>(st);
+    }
+
     this_type& operator ^ (null_entry ne)
 	{
     	return this->insert<null_entry>(ne);
@@ -372,6 +415,12 @@ struct basic_ostream : json_stream
         return this->insert<null_entry>(null_entry{});
     }
 
+    template<typename R>
+    this_type& operator ^ (const parallel_range<R>& pr)
+    {
+        return this->parallel_add(std::begin(pr.range), std::end(pr.range), pr.threads);
+    }
+
     template<typename T>
     this_type& operator ^ (const c_array<T>&  arr)
     {
@@ -396,6 +445,26 @@ struct basic_ostream : json_stream
     	return this->range_add(range.first, range.second);
     }
 
+    // any other range - the items are written as we read them, so views
+    // (std::views::transform, std::views::iota ...) don't need to be copied
+    // into a container first
+    template<std::ranges::input_range R>
+    requires (std::ranges::input_range<const R> && !details::text_range<R, char_type>)
+    this_type& operator ^ (const R& range)
+    {
+    	return this->range_add(std::ranges::begin(range), std::ranges::end(range));
+    }
+
+    // and ranges that can only be read when they are not const (such as
+    // std::views::filter) - these may be single pass ranges
+    template<typename R>
+    requires (std::ranges::input_range<R> && !std::ranges::input_range<const std::remove_reference_t<R>> &&
+              !details::text_range<std::remove_cvref_t<R>, char_type>)
+    this_type& operator ^ (R&& range)
+    {
+    	return this->range_add(std::ranges::begin(range), std::ranges::end(range));
+    }
+
     this_type& operator ^ (const std::string& s)
     {
         return this->insert<std::string>(s);
@@ -414,8 +483,9 @@ struct basic_ostream : json_stream
     this_type& operator ^ (const _pushe&)
     {
         if (this->good() && parent) {
-
-            parent->entries().push_back(std::make_pair("", pt));
+            // we are moving the nodes and not copying them
+            auto added{parent->entries().push_back(std::make_pair(typename proptree_type::key_type{}, proptree_type{}))};
+            added->second.swap(pt);
             return *parent;
         }
         return *this;
@@ -423,13 +493,13 @@ struct basic_ostream : json_stream
 
     this_type& operator ^ (const __end&)
     {
-        if (this->good() && parent && !pt.empty()) {
+        if (this->good() && parent && !blank()) {
             const char* n = "";
             if (parent->element_name()) {
                 n = parent->element_name();
             }
 
-            parent->entries().add_child(n, pt);
+            parent->entries().add_child(n, proptree_type{}).swap(pt);
             childs.reset((proptree_type*)0);
             return *parent;
         }
@@ -449,9 +519,21 @@ struct basic_ostream : json_stream
 
 private:
 
-    template<typename Iter>
-    this_type& range_add(Iter from, Iter to)
-    {
+    template<typename Iter, typename Sent = Iter>
+    this_type& range_add(Iter from, Sent to)
+    {
+        using value_type = std::iter_value_t<Iter>;
+        if constexpr (details::is_native_number_v<value_type>) {
+            // for numbers we don't need to create a node per entry,
+            // we can format the whole array in a single pass, and
+            // store it as the value of this node. None of its chars is
+            // escaped by the writer, so it is written as it is stored
+            if (this->good() && parent && pt.empty() && pt.data().empty()) {
+                details::append_array(pt.data(), std::move(from), std::move(to));
+                this->reset();
+                return *this;
+            }
+        }
     	if (from != to && this->good()) {
     		while (from != to) {
     			*this ^ _array  ^ _name("") ^ *from ^ _pushend;
@@ -464,6 +546,62 @@ private:
     }
 
 
+    // the number of items that we would write in each thread, below
+    // this it is not worth the cost of starting a thread
+    static constexpr std::size_t min_parallel_slice = 256;
+
+    template<typename Iter>
+    this_type& parallel_add(Iter from, Iter to, unsigned int threads)
+    {
+        using value_type = std::remove_cv_t<typename std::iterator_traits<Iter>::value_type>;
+        // numbers are already written in a single pass, they don't need this
+        if constexpr (std::random_access_iterator<Iter> && !details::is_native_number_v<value_type>) {
+            if (threads == 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            const auto count{static_cast<std::size_t>(to - from)};
+            const auto slices{std::min<std::size_t>(threads, count / min_parallel_slice)};
+            if (slices > 1 && this->good()) {
+                std::vector<proptree_type> parts(slices);
+                std::vector<std::exception_ptr> errors(slices);
+                const auto slice_size{count / slices};
+                auto run = [&, from] (std::size_t slice) {
+                    const auto start{from + static_cast<std::ptrdiff_t>(slice * slice_size)};
+                    const auto end{slice + 1 == slices ? from + static_cast<std::ptrdiff_t>(count) :
+                                        start + static_cast<std::ptrdiff_t>(slice_size)};
+                    try {
+                        this_type js{parts[slice]};
+                        js.range_add(start, end);
+                    } catch (...) {
+                        errors[slice] = std::current_exception();
+                    }
+                };
+                {
+                    std::vector<std::jthread> workers;
+                    workers.reserve(slices - 1);
+                    for (std::size_t slice = 1; slice < slices; ++slice) {
+                        workers.emplace_back(run, slice);
+                    }
+                    run(0);
+                }
+                for (const auto& error : errors) {
+                    if (error) {
+                        std::rethrow_exception(error);
+                    }
+                }
+                // the items are moved and not copied into this array
+                for (auto& part : parts) {
+                    for (auto& item : part) {
+                        auto added{pt.push_back(std::make_pair(typename proptree_type::key_type{}, proptree_type{}))};
+                        added->second.swap(item.second);
+                    }
+                }
+                return *this;
+            }
+        }
+        return this->range_add(from, to);
+    }
+
     template<typename T>
     this_type& insert(const T& val)
     {
@@ -487,6 +625,12 @@ private:
         return child;
     }
 
+    // nothing was written into this node
+    bool blank() const
+    {
+        return pt.empty() && pt.data().empty();
+    }
+
 private:
     proptree_type& pt;
     boost::shared_ptr<proptree_type> childs;
@@ -559,9 +703,128 @@ struct basic_output_stream
     basic_output_stream(basic_output_stream&&) = default;
     basic_output_stream& operator = (basic_output_stream&&) = default;
     basic_output_stream(const basic_output_stream&) = default;
-    basic_output_stream& operator = (basic_output_stream&) = default;
+    basic_output_stream& operator = (const basic_output_stream&) = default;
+
+    // remove the current message, so this can be used to create the next one.
+    // The output buffer is not released, so the next call to str would
+    // not need to allocate it again. The nodes of the message are released -
+    // the property tree cannot keep them for reuse, so building the next
+    // message is allocating them again
+    void clear()
+    {
+        tree_root.clear();
+        output.clear();
+    }
+
+    // write the message into the internal output buffer. The returned string
+    // is valid until the next call to either str or clear
+    const std::basic_string<Ch>& str()
+    {
+        details::write_into_string(output, tree_root, false);
+        return output;
+    }
 
     ptree_root tree_root;
+    std::basic_string<Ch> output;
+};
+
+// Pool of output streams for each thread, use it when you are creating
+// many messages, so that the streams and their output buffers are reused
+// between the messages (the nodes of each message are still allocated, see
+// basic_output_stream::clear):
+//  auto out = json::output_stream_pool::acquire();
+//  auto js = *out ^ json::open;
+//  js ^ message ^ json::_end;
+//  send(out->str());
+// Once the handle is out of scope the stream is cleared and returned to the pool
+template<typename Ch>
+class basic_output_stream_pool
+{
+public:
+    using stream_type = basic_output_stream<Ch>;
+    using stream_ptr = std::unique_ptr<stream_type>;
+
+    // we don't want to hold to streams forever if there
+    // was a burst of messages in this thread
+    static constexpr std::size_t max_size = 16;
+
+    class handle
+    {
+    public:
+        explicit handle(stream_ptr s) : stream{std::move(s)}
+        {
+        }
+
+        handle(handle&&) = default;
+
+        // the stream that we are holding goes back to the pool
+        handle& operator = (handle&& other)
+        {
+            if (this != &other) {
+                if (stream) {
+                    basic_output_stream_pool::release(std::move(stream));
+                }
+                stream = std::move(other.stream);
+            }
+            return *this;
+        }
+
+        handle(const handle&) = delete;
+        handle& operator = (const handle&) = delete;
+
+        ~handle()
+        {
+            if (stream) {
+                basic_output_stream_pool::release(std::move(stream));
+            }
+        }
+
+        stream_type& operator * () const
+        {
+            return *stream;
+        }
+
+        stream_type* operator -> () const
+        {
+            return stream.get();
+        }
+
+    private:
+        stream_ptr stream;
+    };
+
+    static handle acquire()
+    {
+        auto& streams = pool();
+        if (streams.empty()) {
+            return handle{std::make_unique<stream_type>()};
+        }
+        auto s{std::move(streams.back())};
+        streams.pop_back();
+        return handle{std::move(s)};
+    }
+
+    // the number of streams that are free to use in this thread
+    static std::size_t available()
+    {
+        return pool().size();
+    }
+
+private:
+    static void release(stream_ptr s)
+    {
+        auto& streams = pool();
+        if (streams.size() < max_size) {
+            s->clear();
+            streams.push_back(std::move(s));
+        }
+    }
+
+    static std::vector<stream_ptr>& pool()
+    {
+        thread_local std::vector<stream_ptr> streams;
+        return streams;
+    }
 };
 
 const struct _start_out_stream {} open = _start_out_stream{};
@@ -0,0 +1,190 @@
+#pragma once
+#include "json_base.h"
+#include "json_fwd.h"
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace json
+{
+
+// The paths in the message that we are going to read. When it is given to
+// istream_root::open, only these paths are added to the tree - the rest of the
+// input is checked and skipped, so it costs much less time and memory:
+//  const json::projection fields{"title.uuid", "title.message_type", "payload.items[*].id"};
+//  json::istream_root root;
+//  root.open(message, fields);
+// A path is a list of keys separated by '.', a key can be followed by [*] for
+// all the items of an array ("[*].id" when the message itself is an array).
+// Everything under the end of a path is added. Keys with '.' or '[' in them
+// cannot be used. The objects on the way to a path are in the tree, only with
+// the members of the path, and the arrays keep all their items (empty when
+// the item does not match). A member on the way to a path that is not an
+// object (or an array, for [*]) is not added, so reading it would fail.
+// When there is no [*] in any of the paths, the parsing stops once all of them
+// were found, and the rest of the input is not checked.
+template<typename Ch>
+class basic_projection
+{
+public:
+    using string_type = std::basic_string<Ch>;
+
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+    // a location in the paths - the root of the message is at 0
+    struct node
+    {
+        std::vector<std::pair<string_type, std::size_t>> members;
+        std::size_t items = npos;       // for [*]
+        bool whole = false;             // a path ends here
+    };
+
+    basic_projection() : nodes(1)
+    {
+    }
+
+    // throw std::invalid_argument for a path that is not valid
+    basic_projection(std::initializer_list<std::string_view> paths) : nodes(1)
+    {
+        for (const auto path : paths) {
+            if (!add(path)) {
+                throw std::invalid_argument{"invalid projection path " + std::string{path}};
+            }
+        }
+    }
+
+    // return false (and don't change anything) when the path is not valid
+    bool add(std::string_view path)
+    {
+        std::vector<std::pair<std::string_view, std::size_t>> steps;     // key and the number of [*] after it
+        if (!split(path, steps)) {
+            return false;
+        }
+        std::size_t current = 0;
+        for (const auto& [key, arrays] : steps) {
+            if (!key.empty()) {
+                current = member(current, key);
+            }
+            for (std::size_t i = 0; i < arrays; ++i) {
+                current = items(current);
+            }
+        }
+        nodes[current].whole = true;
+        return true;
+    }
+
+    bool empty() const
+    {
+        return nodes[0].members.empty() && nodes[0].items == npos && !nodes[0].whole;
+    }
+
+    const node& at(std::size_t index) const
+    {
+        return nodes[index];
+    }
+
+    // the member of the node with this key, or npos
+    template<typename Key>
+    std::size_t find(std::size_t index, const Key& key) const
+    {
+        for (const auto& m : nodes[index].members) {
+            if (m.first == key) {
+                return m.second;
+            }
+        }
+        return npos;
+    }
+
+    std::size_t size() const
+    {
+        return nodes.size();
+    }
+
+    // the number of paths that the parser must find before it can stop, or 0
+    // when it cannot stop before the end since one of the paths has [*]
+    std::size_t stop_after() const
+    {
+        bool open_ended = false;
+        const auto count{paths_under(0, open_ended)};
+        return open_ended ? 0 : count;
+    }
+
+private:
+    static bool split(std::string_view path, std::vector<std::pair<std::string_view, std::size_t>>& steps)
+    {
+        constexpr std::string_view any_item{"[*]"};
+        if (path.empty()) {
+            return false;
+        }
+        while (true) {
+            const auto end{path.find('.')};
+            auto step{path.substr(0, end)};
+            std::size_t arrays = 0;
+            while (step.size() >= any_item.size() && step.substr(step.size() - any_item.size()) == any_item) {
+                step.remove_suffix(any_item.size());
+                ++arrays;
+            }
+            // only the first step can be an array without a key
+            const bool first{steps.empty()};
+            if ((step.empty() && (arrays == 0 || !first)) || step.find_first_of("[]") != std::string_view::npos) {
+                return false;
+            }
+            steps.emplace_back(step, arrays);
+            if (end == std::string_view::npos) {
+                return true;
+            }
+            path.remove_prefix(end + 1);
+        }
+    }
+
+    // a path that is under the end of another path is not counted
+    std::size_t paths_under(std::size_t index, bool& open_ended) const
+    {
+        const auto& n{nodes[index]};
+        if (n.whole) {
+            return 1;
+        }
+        open_ended = open_ended || n.items != npos;
+        std::size_t count = 0;
+        for (const auto& m : n.members) {
+            count += paths_under(m.second, open_ended);
+        }
+        return count;
+    }
+
+    std::size_t member(std::size_t index, std::string_view key)
+    {
+        string_type name;
+        if constexpr (std::is_same_v<Ch, char>) {
+            name = key;
+        } else {
+            name = widen_str(std::string{key});
+        }
+        if (const auto found{find(index, name)}; found != npos) {
+            return found;
+        }
+        nodes.emplace_back();
+        nodes[index].members.emplace_back(std::move(name), nodes.size() - 1);
+        return nodes.size() - 1;
+    }
+
+    std::size_t items(std::size_t index)
+    {
+        if (nodes[index].items == npos) {
+            nodes.emplace_back();
+            nodes[index].items = nodes.size() - 1;
+        }
+        return nodes[index].items;
+    }
+
+private:
+    std::vector<node> nodes;
+};
+
+}   // end of namespace json
@@ -1,41 +1,35 @@
 #include "json_reader.h"
 #include "jsonfwrd.h"
+#include "json_document.h"
+#include "json_timing.h"
+#include <iterator>
 
 namespace json
 {
 
 bool read(std::istream& from, boost::property_tree::ptree& pt)
 {
-    try {
-        boost::property_tree::read_json(from, pt);
-        return true;
-    } catch (std::exception& ) {
-
-        return false;
-    }
+    const std::string input{std::istreambuf_iterator<char>{from}, std::istreambuf_iterator<char>{}};
+    return read(input, pt);
 }
 
 
 bool read(std::wistream& from, boost::property_tree::wptree& pt)
 {
-    try {
-        boost::property_tree::read_json(from, pt);
-        return true;
-    } catch (std::exception& ) {
-        return false;
-    }
+    const std::wstring input{std::istreambuf_iterator<wchar_t>{from}, std::istreambuf_iterator<wchar_t>{}};
+    return read(input, pt);
 }
 
 bool read(const std::string& input, boost::property_tree::ptree& pt)
 {
-    std::istringstream in(input);
-    return read(in, pt);
+    timing::scoped_timer timer{timing::phase::read};
+    return details::parse_tree(input.data(), input.size(), pt);
 }
 
 bool read(const std::wstring& input, boost::property_tree::wptree& pt)
 {
-    std::wistringstream in(input);
-    return read(in, pt);
+    timing::scoped_timer timer{timing::phase::read};
+    return details::parse_tree(input.data(), input.size(), pt);
 }
 
 }   // end of namespace json
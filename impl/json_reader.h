@@ -183,6 +183,10 @@ struct ref_single_entry : reader<T>
 	{
 	}
 
+	ref_single_entry(string_type n, T& default_val) : name(std::move(n)), value(default_val)
+	{
+	}
+
 	bool read(proptree_type& pt)
 	{
 		try {
@@ -212,6 +216,10 @@ struct opt_single_entry : opt_reader<T>
 	{
 	}
 
+	opt_single_entry(string_type n, std::optional<T>& default_val) : name(std::move(n)), value(default_val)
+	{
+	}
+
 	bool read(proptree_type& pt)
 	{
 		try {
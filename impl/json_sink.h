@@ -0,0 +1,393 @@
+#pragma once
+#include "json_emit.h"
+#include "json_ostream.h"
+#include "json_writer.h"
+#include "json_timing.h"
+#include <algorithm>
+#include <concepts>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#   define JSON_PARSER_HAVE_POSIX_SINK
+#   include <cerrno>
+#   include <sys/uio.h>
+#   include <unistd.h>
+#endif
+
+// Output sinks - targets for writing JSON other than std::ostream or a string
+// that is returned from the write function. A sink is anything that has:
+//  char_type               - the type of the chars it is writing
+//  bool write(const char_type*, std::size_t)
+//                          - add the chars to the output, return false if
+//                            not all of them were accepted (error or no space left)
+//  bool flush()            - make sure that everything that was written is out
+// This allow writing large messages directly into a file or socket:
+//  json::fd_sink out{socket_fd};
+//  json::write(out, message);
+namespace json
+{
+
+template<typename S>
+concept output_sink = requires(S& sink, const typename S::char_type* from, std::size_t n) {
+    typename S::char_type;
+    { sink.write(from, n) } -> std::same_as<bool>;
+    { sink.flush() } -> std::same_as<bool>;
+};
+
+// write to a string that is growing as required
+template<typename Ch>
+class basic_string_sink
+{
+public:
+    using char_type = Ch;
+    using string_type = std::basic_string<char_type>;
+
+    basic_string_sink() = default;
+
+    explicit basic_string_sink(string_type& target) : output{&target}
+    {
+    }
+
+    basic_string_sink(const basic_string_sink&) = delete;
+    basic_string_sink& operator = (const basic_string_sink&) = delete;
+
+    bool write(const char_type* from, std::size_t n)
+    {
+        output->append(from, n);
+        return true;
+    }
+
+    bool flush()
+    {
+        return true;
+    }
+
+    const string_type& str() const
+    {
+        return *output;
+    }
+
+    // remove what was written so far, but keep the memory for the next message
+    void clear()
+    {
+        output->clear();
+    }
+
+private:
+    string_type buffer;
+    string_type* output = &buffer;
+};
+
+// write into a fixed size buffer. When the buffer is full, we report it and
+// the output is truncated. To write a message that is larger than the buffer
+// in parts, use chunked_writer, that continues from where it stopped:
+//  json::span_sink out{buffer};
+//  if (json::write(out, message)) {
+//      send(out.data());
+//  }
+template<typename Ch>
+class basic_span_sink
+{
+public:
+    using char_type = Ch;
+
+    explicit basic_span_sink(std::span<char_type> to) : buffer{to}
+    {
+    }
+
+    bool write(const char_type* from, std::size_t n)
+    {
+        const auto count{std::min(n, buffer.size() - used)};
+        std::char_traits<char_type>::copy(buffer.data() + used, from, count);
+        used += count;
+        overflow = overflow || count != n;
+        return !overflow;
+    }
+
+    bool flush()
+    {
+        return !overflow;
+    }
+
+    // true when there was more output than we could write into the buffer
+    bool full() const
+    {
+        return overflow;
+    }
+
+    // the part of the buffer that was written so far
+    std::span<char_type> data() const
+    {
+        return buffer.first(used);
+    }
+
+    std::size_t size() const
+    {
+        return used;
+    }
+
+    // start a new message
+    void reset(std::span<char_type> to)
+    {
+        buffer = to;
+        used = 0;
+        overflow = false;
+    }
+
+private:
+    std::span<char_type> buffer;
+    std::size_t used = 0;
+    bool overflow = false;
+};
+
+// write to C FILE
+class file_sink
+{
+public:
+    using char_type = char;
+
+    explicit file_sink(std::FILE* f) : file{f}
+    {
+    }
+
+    bool write(const char_type* from, std::size_t n)
+    {
+        return std::fwrite(from, sizeof(char_type), n, file) == n;
+    }
+
+    bool flush()
+    {
+        return std::fflush(file) == 0;
+    }
+
+private:
+    std::FILE* file = nullptr;
+};
+
+#ifdef JSON_PARSER_HAVE_POSIX_SINK
+// write to file descriptor - file or socket. We are collecting the output
+// into a buffer, and once it is full we write it. Large blocks are not
+// copied into the buffer, they are written together with the buffer in
+// a single call.
+// This is for blocking descriptors - once a write fails (including EAGAIN on
+// a non blocking socket) write returns false, and json::write stops writing
+// the message, so the output is cut short. For non blocking sockets use
+// chunked_writer, that can continue from where it stopped
+class fd_sink
+{
+public:
+    using char_type = char;
+
+    static constexpr std::size_t default_size = 64 * 1024;
+
+    explicit fd_sink(int fd, std::size_t buffer_size = default_size) : descriptor{fd}, capacity{buffer_size}
+    {
+        buffer.reserve(capacity);
+    }
+
+    fd_sink(const fd_sink&) = delete;
+    fd_sink& operator = (const fd_sink&) = delete;
+
+    ~fd_sink()
+    {
+        flush();
+    }
+
+    // when this returns false after a small block, nothing of it was taken
+    // (it can be written again), a large block may be written in part
+    bool write(const char_type* from, std::size_t n)
+    {
+        if (buffer.size() + n <= capacity) {
+            buffer.insert(buffer.end(), from, from + n);
+            return true;
+        }
+        if (n < capacity / 2) {
+            // when we cannot write, the buffer must not grow without a limit
+            if (!flush()) {
+                return false;
+            }
+            buffer.insert(buffer.end(), from, from + n);
+            return true;
+        }
+        return write_block(from, n);
+    }
+
+    bool flush()
+    {
+        std::size_t start = 0;
+        bool ok = true;
+        while (start < buffer.size()) {
+            const auto w{::write(descriptor, buffer.data() + start, buffer.size() - start)};
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ok = false;
+                break;
+            }
+            start += static_cast<std::size_t>(w);
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(start));
+        return ok;
+    }
+
+    int fd() const
+    {
+        return descriptor;
+    }
+
+private:
+    // write the buffer and the block with a single system call
+    bool write_block(const char_type* from, std::size_t n)
+    {
+        while (n > 0) {
+            iovec parts[2] = {
+                {buffer.data(), buffer.size()},
+                {const_cast<char_type*>(from), n}
+            };
+            const int first = buffer.empty() ? 1 : 0;
+            const auto w{::writev(descriptor, parts + first, 2 - first)};
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            auto count{static_cast<std::size_t>(w)};
+            const auto from_buffer{std::min(count, buffer.size())};
+            buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(from_buffer));
+            count -= from_buffer;
+            from += count;
+            n -= count;
+        }
+        return true;
+    }
+
+private:
+    int descriptor = -1;
+    std::size_t capacity = default_size;
+    std::vector<char_type> buffer;
+};
+#endif  // JSON_PARSER_HAVE_POSIX_SINK
+
+using string_sink = basic_string_sink<char>;
+using wstring_sink = basic_string_sink<wchar_t>;
+using span_sink = basic_span_sink<char>;
+using wspan_sink = basic_span_sink<wchar_t>;
+
+namespace details
+{
+
+// connect the output sink to the tree writer. Once the sink is refusing to
+// take more input, we are not trying to write into it any more - the rest
+// of the message is lost, and the write returns false
+template<typename Sink>
+struct sink_adapter
+{
+    using char_type = typename Sink::char_type;
+
+    explicit sink_adapter(Sink& s) : sink{s}
+    {
+    }
+
+    void put(char_type c)
+    {
+        write(&c, 1);
+    }
+
+    void write(const char_type* from, std::size_t n)
+    {
+        if (ok) {
+            ok = sink.write(from, n);
+        }
+    }
+
+    void fill(char_type c, std::size_t n)
+    {
+        constexpr std::size_t block = 64;
+        char_type spaces[block];
+        std::char_traits<char_type>::assign(spaces, block, c);
+        while (n > 0 && ok) {
+            const auto count{std::min(n, block)};
+            write(spaces, count);
+            n -= count;
+        }
+    }
+
+    Sink& sink;
+    bool ok = true;
+};
+
+inline const boost::property_tree::ptree& tree_of(const ostream& os)
+{
+    return os.entries();
+}
+
+inline const boost::property_tree::wptree& tree_of(const wostream& os)
+{
+    return os.entries();
+}
+
+template<typename Ch> inline
+const typename basic_output_stream<Ch>::ptree_root& tree_of(const basic_output_stream<Ch>& os)
+{
+    return os.tree_root;
+}
+
+inline const boost::property_tree::ptree& tree_of(entry_writer& ga)
+{
+    return ga.node();
+}
+
+inline const boost::property_tree::wptree& tree_of(wentry_writer& ga)
+{
+    return ga.node();
+}
+
+inline const boost::property_tree::ptree& tree_of(array_writer& ga)
+{
+    return ga.get_nodes();
+}
+
+inline const boost::property_tree::wptree& tree_of(warray_writer& ga)
+{
+    return ga.get_nodes();
+}
+
+inline const boost::property_tree::ptree& tree_of(generate_array& ga)
+{
+    return ga.get_root();
+}
+
+inline const boost::property_tree::wptree& tree_of(wgenerate_array& ga)
+{
+    return ga.get_root();
+}
+
+}   // end of namespace details
+
+// write the JSON into the sink - this can be any of the types that you can
+// use with the other write functions (ostream, output_stream, entry_writer,
+// array_writer, generate_array and their wide versions).
+// return false if the message cannot be written as JSON or the sink is not
+// accepting all of it - in this case the output is truncated, it cannot be
+// continued from where it stopped (see chunked_writer for this)
+template<output_sink Sink, typename Source>
+requires requires (Source& s) { details::tree_of(s); }
+bool write(Sink& sink, Source& from, bool indent = false)
+{
+    const auto& tree{details::tree_of(from)};
+    using char_type = typename std::remove_cvref_t<decltype(tree)>::key_type::value_type;
+    static_assert(std::is_same_v<char_type, typename Sink::char_type>, "the sink must use the same char type as the message");
+
+    timing::scoped_timer timer{timing::phase::write};
+    details::sink_adapter<Sink> adapter{sink};
+    if (!details::write_document(adapter, tree, indent)) {
+        return false;
+    }
+    return sink.flush() && adapter.ok;
+}
+
+}   // end of namespace json
@@ -0,0 +1,265 @@
+#include "json_timing.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace json::timing
+{
+
+const char* name(phase p)
+{
+    switch (p) {
+    case phase::read:
+        return "read";
+    case phase::open:
+        return "open";
+    case phase::deserialize:
+        return "deserialize";
+    case phase::serialize:
+        return "serialize";
+    case phase::write:
+        return "write";
+    }
+    return "unknown";
+}
+
+void histogram::merge(const histogram& other)
+{
+    for (std::size_t b = 0; b < bucket_count; ++b) {
+        counts[b] += other.counts[b];
+    }
+}
+
+std::uint64_t histogram::count() const
+{
+    std::uint64_t total = 0;
+    for (const auto c : counts) {
+        total += c;
+    }
+    return total;
+}
+
+std::uint64_t histogram::percentile(double part) const
+{
+    const auto total{count()};
+    if (total == 0) {
+        return 0;
+    }
+    const auto wanted{std::max<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(part * static_cast<double>(total))), 1)};
+    std::uint64_t seen = 0;
+    for (std::size_t b = 0; b < bucket_count; ++b) {
+        seen += counts[b];
+        if (seen >= wanted) {
+            return bucket_limit(b);
+        }
+    }
+    return max();
+}
+
+std::uint64_t histogram::max() const
+{
+    for (auto b = bucket_count; b > 0; --b) {
+        if (counts[b - 1] > 0) {
+            return bucket_limit(b - 1);
+        }
+    }
+    return 0;
+}
+
+summary summarize(phase p)
+{
+    const auto h{snapshot(p)};
+    return summary{h.count(), h.percentile(0.5), h.percentile(0.99), h.percentile(0.999), h.max()};
+}
+
+#ifdef JSON_PARSER_TIMING
+namespace
+{
+
+// the histograms of a single thread - only this thread is writing into
+// them, the atomics are so we can read them from other threads
+struct thread_histograms
+{
+    std::array<std::array<std::atomic<std::uint64_t>, histogram::bucket_count>, phase_count> counts{};
+};
+
+struct registry
+{
+    std::mutex lock;
+    std::vector<thread_histograms*> threads;
+    // the times of the threads that are done
+    std::array<histogram, phase_count> retired;
+};
+
+registry& all_threads()
+{
+    static registry threads;
+    return threads;
+}
+
+std::atomic<bool> is_on{false};
+std::atomic<hook_type> current_hook{nullptr};
+
+// the phases that we are measuring now in this thread
+thread_local std::array<bool, phase_count> measuring{};
+
+// the histograms of this thread are in the registry as long as the thread is
+// running. When it is done, its times are added to the retired histograms, so
+// they are not lost and we are not keeping the histograms of each thread
+class thread_entry
+{
+public:
+    thread_entry() : histograms{std::make_unique<thread_histograms>()}
+    {
+        auto& r{all_threads()};
+        std::lock_guard guard{r.lock};
+        r.threads.push_back(histograms.get());
+    }
+
+    ~thread_entry()
+    {
+        auto& r{all_threads()};
+        std::lock_guard guard{r.lock};
+        for (std::size_t p = 0; p < phase_count; ++p) {
+            const auto& counts{histograms->counts[p]};
+            for (std::size_t b = 0; b < histogram::bucket_count; ++b) {
+                if (const auto c{counts[b].load(std::memory_order_relaxed)}) {
+                    r.retired[p].add(b, c);
+                }
+            }
+        }
+        r.threads.erase(std::find(r.threads.begin(), r.threads.end(), histograms.get()));
+    }
+
+    thread_entry(const thread_entry&) = delete;
+    thread_entry& operator = (const thread_entry&) = delete;
+
+    thread_histograms& get()
+    {
+        return *histograms;
+    }
+
+private:
+    std::unique_ptr<thread_histograms> histograms;
+};
+
+thread_histograms& this_thread()
+{
+    thread_local thread_entry mine;
+    return mine.get();
+}
+
+}   // end of local namespace
+
+void enable(bool on)
+{
+    is_on.store(on, std::memory_order_relaxed);
+}
+
+bool enabled()
+{
+    return is_on.load(std::memory_order_relaxed);
+}
+
+void set_hook(hook_type hook)
+{
+    current_hook.store(hook, std::memory_order_relaxed);
+}
+
+void record(phase p, std::uint64_t ns)
+{
+    auto& counter{this_thread().counts[static_cast<std::size_t>(p)][histogram::bucket(ns)]};
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (const auto hook{current_hook.load(std::memory_order_relaxed)}) {
+        hook(p, ns);
+    }
+}
+
+bool begin(phase p)
+{
+    auto& active{measuring[static_cast<std::size_t>(p)]};
+    if (active || !enabled()) {
+        return false;
+    }
+    active = true;
+    return true;
+}
+
+void end(phase p, std::uint64_t ns)
+{
+    measuring[static_cast<std::size_t>(p)] = false;
+    record(p, ns);
+}
+
+histogram snapshot(phase p)
+{
+    auto& r{all_threads()};
+    std::lock_guard guard{r.lock};
+    histogram result{r.retired[static_cast<std::size_t>(p)]};
+    for (const auto& thread : r.threads) {
+        const auto& counts{thread->counts[static_cast<std::size_t>(p)]};
+        for (std::size_t b = 0; b < histogram::bucket_count; ++b) {
+            if (const auto c{counts[b].load(std::memory_order_relaxed)}) {
+                result.add(b, c);
+            }
+        }
+    }
+    return result;
+}
+
+// note that a thread that is recording at the same time may keep a count
+void reset()
+{
+    auto& r{all_threads()};
+    std::lock_guard guard{r.lock};
+    r.retired.fill(histogram{});
+    for (const auto& thread : r.threads) {
+        for (auto& counts : thread->counts) {
+            for (auto& c : counts) {
+                c.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+#else
+void enable(bool)
+{
+}
+
+bool enabled()
+{
+    return false;
+}
+
+void set_hook(hook_type)
+{
+}
+
+void record(phase, std::uint64_t)
+{
+}
+
+bool begin(phase)
+{
+    return false;
+}
+
+void end(phase, std::uint64_t)
+{
+}
+
+histogram snapshot(phase)
+{
+    return histogram{};
+}
+
+void reset()
+{
+}
+#endif  // JSON_PARSER_TIMING
+
+}   // end of namespace json::timing
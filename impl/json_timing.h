@@ -0,0 +1,177 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Measuring the time that we are spending in each phase of the work - reading
+// the input, extracting it into C++ types, creating the output and writing it.
+// This is only built in when building with JSON_PARSER_TIMING (cmake option with
+// the same name), and then it must be enabled at run time as well:
+//  json::timing::enable(true);
+//  ...
+//  const auto open{json::timing::summarize(json::timing::phase::open)};
+//  std::cout << "p99 of open is " << open.p99 << "ns\n";
+// The times are saved into a histogram for each thread, so recording them does
+// not require any lock. When a thread is done, its times are added to a single
+// histogram of the threads that are done, and its own histogram is released.
+// It is also possible to get each measurement with a hook.
+// When a phase is nested in itself (a struct that has struct members), only
+// the outer one is measured, so the time is not counted twice.
+// Without JSON_PARSER_TIMING there is no cost for this at all. The library and
+// the code that is using it can be built with a different setting - in this
+// case only the phases that are in code that was built with it are measured.
+namespace json::timing
+{
+
+#ifdef JSON_PARSER_TIMING
+constexpr bool timing_enabled = true;
+#else
+constexpr bool timing_enabled = false;
+#endif  // JSON_PARSER_TIMING
+
+enum class phase : std::uint8_t
+{
+    read,           // json::read - parsing into a property tree
+    open,           // istream_root::open - parsing into the root
+    deserialize,    // json::util::deserialized - reading a struct
+    serialize,      // json::util::serialized - adding a struct to the message
+    write           // json::write/wwrite - writing the message as text
+};
+
+constexpr std::size_t phase_count = 5;
+
+const char* name(phase p);
+
+// Histogram of times in nanoseconds. Each power of 2 is divided into 16
+// buckets, so the values are kept with about 6% accuracy
+class histogram
+{
+public:
+    static constexpr unsigned sub_bits = 4;
+    static constexpr std::size_t sub_count = std::size_t{1} << sub_bits;
+    static constexpr std::size_t bucket_count = (64 - sub_bits + 1) * sub_count;
+
+    static constexpr std::size_t bucket(std::uint64_t ns)
+    {
+        if (ns < sub_count) {
+            return static_cast<std::size_t>(ns);
+        }
+        const auto shift{static_cast<unsigned>(63 - std::countl_zero(ns)) - sub_bits};
+        return (shift + 1) * sub_count + static_cast<std::size_t>(ns >> shift) - sub_count;
+    }
+
+    // the largest value that is in the bucket
+    static constexpr std::uint64_t bucket_limit(std::size_t b)
+    {
+        const auto shift{static_cast<unsigned>(b / sub_count)};
+        const auto sub{static_cast<std::uint64_t>(b % sub_count)};
+        if (shift == 0) {
+            return sub;
+        }
+        return ((sub_count + sub + 1) << (shift - 1)) - 1;
+    }
+
+    void record(std::uint64_t ns)
+    {
+        ++counts[bucket(ns)];
+    }
+
+    void add(std::size_t b, std::uint64_t count)
+    {
+        counts[b] += count;
+    }
+
+    void merge(const histogram& other);
+
+    std::uint64_t count() const;
+
+    // the value that this part (0 to 1) of the samples are not larger than
+    std::uint64_t percentile(double part) const;
+
+    std::uint64_t max() const;
+
+private:
+    std::array<std::uint64_t, bucket_count> counts{};
+};
+
+struct summary
+{
+    std::uint64_t count = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t p999 = 0;
+    std::uint64_t max = 0;
+};
+
+// called for each measurement (from the thread that did the work)
+using hook_type = void (*)(phase p, std::uint64_t ns);
+
+void enable(bool on);
+bool enabled();
+void set_hook(hook_type hook);
+
+// the times from all the threads
+histogram snapshot(phase p);
+summary summarize(phase p);
+void reset();
+
+void record(phase p, std::uint64_t ns);
+
+// return false when we are already measuring this phase in this thread
+// (or timing is not enabled), otherwise this must be followed by end
+bool begin(phase p);
+void end(phase p, std::uint64_t ns);
+
+// the two versions of this are in different namespaces, so code that is
+// built with and without JSON_PARSER_TIMING can be linked together
+#ifdef JSON_PARSER_TIMING
+inline namespace measured
+{
+
+// measure the time from the construction to the destruction
+class scoped_timer
+{
+public:
+    explicit scoped_timer(phase p) : what{p}, active{begin(p)}
+    {
+        if (active) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~scoped_timer()
+    {
+        if (active) {
+            const auto elapsed{std::chrono::steady_clock::now() - start};
+            end(what, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    }
+
+    scoped_timer(const scoped_timer&) = delete;
+    scoped_timer& operator = (const scoped_timer&) = delete;
+
+private:
+    phase what;
+    bool active = false;
+    std::chrono::steady_clock::time_point start;
+};
+
+}   // end of namespace measured
+#else
+inline namespace not_measured
+{
+
+class scoped_timer
+{
+public:
+    explicit scoped_timer(phase)
+    {
+    }
+};
+
+}   // end of namespace not_measured
+#endif  // JSON_PARSER_TIMING
+
+}   // end of namespace json::timing
@@ -2,15 +2,21 @@
 
 #include "json_ostream.h"
 #include "json_istream.h"
+#include "json_format.h"
+#include "json_timing.h"
 #include <boost/fusion/adapted/struct.hpp>
 #include <boost/fusion/include/for_each.hpp>
 #include <boost/phoenix/phoenix.hpp>
 #include <boost/mpl/size.hpp>
 #include <span>
+#include <algorithm>
 #include <cassert>
 #include <optional>
 #include <type_traits>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
 
 namespace json
 {
@@ -64,6 +70,25 @@ namespace util
 //  }
 //
 
+// the labels of the struct members, in the same order as the members
+using label_list = std::span<const char* const>;
+
+// Labels for the members of a type - this is an alternative to passing the
+// labels on each call. The number of labels is checked at compile time.
+// At the global namespace, after BOOST_FUSION_ADAPT_STRUCT:
+//  JSON_LABELS(baz, "json-foo", "json-bar");
+// and then:
+//  json::ostream& operator ^ (json::ostream& js, const baz& b) {
+//      return json::util::serialized(js, b);
+//  }
+template<typename T>
+struct labels;
+
+template<typename T>
+concept has_labels = requires {
+    { labels<T>::names[0] } -> std::convertible_to<const char*>;
+};
+
 namespace private_
 {
 
@@ -197,16 +222,148 @@ istream& extract_from(istream& with, T& to, const char* label)
     return extract_simple(with, to, label);
 }
 
+// Adding the members of a struct directly as children of the node.
+// The values that we know how to format (numbers, strings, optional of these
+// and lists of numbers) are formatted into the data of their child, the same
+// as the stream is storing them, without going through a child stream and a
+// lookup of the label for each of them. The other members are written with
+// their operator ^ as before. The keys are made from the labels once for each
+// type that has labels (see JSON_LABELS), or on each call when the labels are
+// passed to the function
+struct compiled_labels
+{
+    std::vector<std::string> keys;
+    bool usable = true;         // false when the tree is handling the labels in a special way
+};
 
-}   // end of namespace private_
+inline compiled_labels compile_labels(label_list labels)
+{
+    compiled_labels compiled;
+    compiled.keys.reserve(labels.size());
+    for (auto i = labels.begin(); i != labels.end(); ++i) {
+        std::string label{*i};
+        // the tree is treating these as paths or replacing the
+        // existing value, we cannot add them directly
+        if (label.empty() || label.find('.') != std::string::npos ||
+                std::find_if(labels.begin(), i, [&label](const char* l) { return label == l; }) != i) {
+            compiled.usable = false;
+        }
+        compiled.keys.push_back(std::move(label));
+    }
+    return compiled;
+}
+
+template<has_labels T>
+const compiled_labels& compiled_for()
+{
+    static const compiled_labels compiled{compile_labels(labels<T>::names)};
+    return compiled;
+}
 
 template<typename T>
-inline auto build_entry(ostream& js, const T& from, std::span<const char*> labels) -> ostream& {
-    using boost::phoenix::arg_names::arg1;
-    using namespace json::literals;
+constexpr bool is_list_v = is_specialization<T, std::vector>::value ||
+        is_specialization<T, std::list>::value ||
+        is_specialization<T, std::set>::value ||
+        is_specialization<T, std::unordered_set>::value;
+
+template<typename T>
+constexpr bool is_number_list()
+{
+    if constexpr (is_list_v<T>) {
+        return details::is_native_number_v<typename T::value_type>;
+    } else {
+        return false;
+    }
+}
+
+template<typename T>
+constexpr bool is_direct_scalar_v = details::is_native_number_v<T> || std::is_same_v<T, std::string>;
+
+// the values that we can format the same way as insert_to without a child stream
+template<typename T>
+constexpr bool is_direct_value()
+{
+    if constexpr (is_direct_scalar_v<T> || is_number_list<T>()) {
+        return true;
+    } else if constexpr (is_specialization<T, std::optional>::value) {
+        return is_direct_scalar_v<typename T::value_type> || is_number_list<typename T::value_type>();
+    } else {
+        return false;
+    }
+}
+
+// the data of the node, as the stream would have stored it
+template<typename T>
+void format_value(std::string& to, const T& value)
+{
+    if constexpr (details::is_native_number_v<T>) {
+        char buffer[details::max_number_chars<T>()];
+        to.append(buffer, details::format_number<T>(buffer, value));
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        to = entry<std::string>{"", value}.value;
+    } else if constexpr (is_number_list<T>()) {
+        details::append_array(to, value.begin(), value.end());
+    } else if (value) {
+        format_value(to, *value);
+    } else if constexpr (is_number_list<typename T::value_type>()) {
+        to = "[]";      // same as insert_opt_list
+    } else {
+        to = "null";
+    }
+}
+
+// Entries is true for build_entry, false for serialized - these are
+// writing the members in a different way. Return false if we cannot
+// add the members directly, in which case nothing is added to the stream
+template<bool Entries, typename T>
+bool add_members(ostream& os, const T& from, label_list labels, const compiled_labels& compiled)
+{
+    // when we have a name here, the struct is written as a value of another
+    // struct, and its members are mixed with the members of the other
+    const char* name{os.element_name()};
+    if (!os.good() || (name && *name) || !compiled.usable) {
+        return false;
+    }
+    auto& pt{os.entries()};
+    // once there are other children in the node, a member may have to
+    // replace one of them, as the stream is doing for the same name
+    bool replacing = !pt.empty();
+    std::size_t index = 0;
+    boost::fusion::for_each(from, [&](const auto& member) {
+            using member_type = std::remove_cvref_t<decltype(member)>;
+            const auto at{index++};
+            if constexpr (Entries ? is_number_list<member_type>() : is_direct_value<member_type>()) {
+                if (replacing) {
+                    if (auto found{pt.find(compiled.keys[at])}; found != pt.not_found()) {
+                        found->second.data().clear();
+                        format_value(found->second.data(), member);
+                        return;
+                    }
+                }
+                auto added{pt.push_back(std::make_pair(compiled.keys[at], boost::property_tree::ptree{}))};
+                format_value(added->second.data(), member);
+            } else {
+                if constexpr (Entries) {
+                    auto rr = os ^ _start(labels[at]);
+                    rr ^ member ^ _end;
+                } else {
+                    insert_to(os, member, labels[at]);
+                }
+                replacing = true;
+            }
+        }
+    );
+    return true;
+}
 
+template<typename T>
+ostream& build_members(ostream& js, const T& from, label_list labels, const compiled_labels& compiled)
+{
     assert(labels.size() == boost::mpl::size<T>::type::value);
 
+    if (add_members<true>(js, from, labels, compiled)) {
+        return js;
+    }
     boost::fusion::for_each(from, [&js, start = labels.begin(), end = labels.end()](auto&& arg1) mutable {
             assert(start != end);      
             auto rr = js ^ _start(*start);
@@ -218,46 +375,62 @@ inline auto build_entry(ostream& js, const T& from, std::span<const char*> label
 }
 
 template<typename T>
-inline auto read_entry(istream& js, T& to, std::span<const char*> labels) -> istream& {
-    using boost::phoenix::arg_names::arg1;
-    using namespace json::literals;
-
+ostream& serialize_members(ostream& os, const T& from, label_list labels, const compiled_labels& compiled)
+{
     assert(labels.size() == boost::mpl::size<T>::type::value);
 
-    boost::fusion::for_each(to, [&js, start = labels.begin(), end = labels.end()] (auto&& arg1) mutable {
+    timing::scoped_timer timer{timing::phase::serialize};
+    if (add_members<false>(os, from, labels, compiled)) {
+        os.reset();
+        return os;
+    }
+    boost::fusion::for_each(from, [&os, start = labels.begin(), end = labels.end()](auto&& arg1) mutable {
             assert(start != end);
-            auto rr = js ^ _child(js, _name(*start));
-            rr ^ arg1;
+            insert_to(os, arg1, *start);
             ++start;
+            return os;
         }
     );
-    return js;
+    return os;
+}
+
+}   // end of namespace private_
+
+template<typename T>
+inline auto build_entry(ostream& js, const T& from, label_list labels) -> ostream& {
+    return private_::build_members(js, from, labels, private_::compile_labels(labels));
 }
 
 template<typename T>
-inline auto serialized(ostream& os, const T& from, std::span<const char*> labels) -> ostream& {
+inline auto read_entry(istream& js, T& to, label_list labels) -> istream& {
     using boost::phoenix::arg_names::arg1;
     using namespace json::literals;
 
     assert(labels.size() == boost::mpl::size<T>::type::value);
 
-    boost::fusion::for_each(from, [&os, start = labels.begin(), end = labels.end()](auto&& arg1) mutable {
+    boost::fusion::for_each(to, [&js, start = labels.begin(), end = labels.end()] (auto&& arg1) mutable {
             assert(start != end);
-            private_::insert_to(os, arg1, *start);
+            auto rr = js ^ _child(js, _name(*start));
+            rr ^ arg1;
             ++start;
-            return os;
         }
     );
-    return os;
+    return js;
+}
+
+template<typename T>
+inline auto serialized(ostream& os, const T& from, label_list labels) -> ostream& {
+    return private_::serialize_members(os, from, labels, private_::compile_labels(labels));
 }
 
 template<typename T>
-inline auto deserialized(istream& os, T& from, std::span<const char*> labels) -> istream& {
+inline auto deserialized(istream& os, T& from, label_list labels) -> istream& {
     using boost::phoenix::arg_names::arg1;
     using namespace json::literals;
 
     assert(labels.size() == boost::mpl::size<T>::type::value);
 
+    timing::scoped_timer timer{timing::phase::deserialize};
     boost::fusion::for_each(from, [&os, start = labels.begin(), end = labels.end()](auto&& arg1) mutable {
             assert(start != end);
             private_::extract_from(os, arg1, *start);
@@ -268,6 +441,55 @@ inline auto deserialized(istream& os, T& from, std::span<const char*> labels) ->
     return os;
 }
 
+template<typename T, std::size_t N>
+constexpr bool matching_labels = N == boost::mpl::size<T>::type::value;
+
+// when passing the labels as an array, the number of labels is checked at compile time
+template<typename T, std::size_t N>
+inline auto build_entry(ostream& js, const T& from, const char* const (&labels)[N]) -> ostream& {
+    static_assert(matching_labels<T, N>, "the number of labels must match the number of members");
+    return build_entry(js, from, label_list{labels});
+}
+
+template<typename T, std::size_t N>
+inline auto read_entry(istream& js, T& to, const char* const (&labels)[N]) -> istream& {
+    static_assert(matching_labels<T, N>, "the number of labels must match the number of members");
+    return read_entry(js, to, label_list{labels});
+}
+
+template<typename T, std::size_t N>
+inline auto serialized(ostream& os, const T& from, const char* const (&labels)[N]) -> ostream& {
+    static_assert(matching_labels<T, N>, "the number of labels must match the number of members");
+    return serialized(os, from, label_list{labels});
+}
+
+template<typename T, std::size_t N>
+inline auto deserialized(istream& os, T& from, const char* const (&labels)[N]) -> istream& {
+    static_assert(matching_labels<T, N>, "the number of labels must match the number of members");
+    return deserialized(os, from, label_list{labels});
+}
+
+// using the labels that were set with JSON_LABELS
+template<has_labels T>
+inline auto build_entry(ostream& js, const T& from) -> ostream& {
+    return private_::build_members(js, from, labels<T>::names, private_::compiled_for<T>());
+}
+
+template<has_labels T>
+inline auto read_entry(istream& js, T& to) -> istream& {
+    return read_entry(js, to, labels<T>::names);
+}
+
+template<has_labels T>
+inline auto serialized(ostream& os, const T& from) -> ostream& {
+    return private_::serialize_members(os, from, labels<T>::names, private_::compiled_for<T>());
+}
+
+template<has_labels T>
+inline auto deserialized(istream& os, T& from) -> istream& {
+    return deserialized(os, from, labels<T>::names);
+}
+
 // note that this requires that you would have `operator ^` implemented for T!
 template<typename T>
 inline auto into(const std::string& jstr) -> T {
@@ -303,3 +525,11 @@ inline auto loads(const std::string& from) -> T {
 
 }   // end of namespace json
 
+// set the labels for the members of a fusion adapted struct, this must
+// be used at the global namespace, see json::util::labels
+#define JSON_LABELS(type, ...)                                                  \
+    template<> struct json::util::labels<type> {                                \
+        static constexpr const char* names[] = {__VA_ARGS__};                   \
+        static_assert(json::util::matching_labels<type, std::size(names)>,      \
+            "the number of labels for " #type " must match the number of members"); \
+    }
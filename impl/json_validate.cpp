@@ -0,0 +1,438 @@
+#include "json_validate.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace json
+{
+
+namespace
+{
+
+constexpr std::uint64_t repeat(unsigned char c)
+{
+    return 0x0101010101010101ull * c;
+}
+
+// true when one of the bytes in the block is zero
+constexpr bool has_zero(std::uint64_t block)
+{
+    return ((block - repeat(0x01)) & ~block & repeat(0x80)) != 0;
+}
+
+// true when one of the bytes in the block must be checked in a string - the end
+// of the string, an escape, a control char or a part of a multi byte sequence
+constexpr bool string_special(std::uint64_t block)
+{
+    const bool control{((block - repeat(0x20)) & ~block & repeat(0x80)) != 0};
+    return control || (block & repeat(0x80)) != 0 || has_zero(block ^ repeat('"')) || has_zero(block ^ repeat('\\'));
+}
+
+bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+class validator
+{
+public:
+    validator(std::string_view input, const validate_limits& limits) :
+            start{input.data()}, cur{input.data()}, end{input.data() + input.size()},
+            max_depth{std::min(limits.max_depth, validate_limits::max_supported_depth)}
+    {
+    }
+
+    validate_result run()
+    {
+        skip_introduction();
+        // we don't have a stack of calls, so we are keeping the state here
+        enum class next_t { value, key, after_value };
+        auto next{next_t::value};
+        while (true) {
+            skip_ws();
+            if (cur == end) {
+                return depth == 0 && next == next_t::after_value ? validate_result{} : fail(validate_error::unexpected_end);
+            }
+            switch (next) {
+            case next_t::value:
+                if (*cur == '{' || *cur == '[') {
+                    const bool object{*cur == '{'};
+                    if (!push(object)) {
+                        return fail(validate_error::too_deep);
+                    }
+                    ++cur;
+                    skip_ws();
+                    if (cur != end && *cur == (object ? '}' : ']')) {
+                        ++cur;
+                        --depth;
+                        next = next_t::after_value;
+                    } else {
+                        next = object ? next_t::key : next_t::value;
+                    }
+                } else if (const auto error{scalar()}; error != validate_error::none) {
+                    return fail(error);
+                } else {
+                    next = next_t::after_value;
+                }
+                break;
+            case next_t::key:
+                if (*cur != '"') {
+                    return fail(validate_error::unexpected_char);
+                }
+                ++cur;
+                if (const auto error{string()}; error != validate_error::none) {
+                    return fail(error);
+                }
+                skip_ws();
+                if (cur == end) {
+                    return fail(validate_error::unexpected_end);
+                }
+                if (*cur != ':') {
+                    return fail(validate_error::unexpected_char);
+                }
+                ++cur;
+                next = next_t::value;
+                break;
+            case next_t::after_value:
+                if (depth == 0) {
+                    return fail(validate_error::trailing_data);
+                }
+                if (*cur == ',') {
+                    ++cur;
+                    next = in_object() ? next_t::key : next_t::value;
+                } else if (*cur == (in_object() ? '}' : ']')) {
+                    ++cur;
+                    --depth;
+                } else {
+                    return fail(validate_error::unexpected_char);
+                }
+                break;
+            }
+        }
+    }
+
+private:
+    validate_result fail(validate_error error) const
+    {
+        return validate_result{error, static_cast<std::size_t>(cur - start)};
+    }
+
+    // each level is a single bit - 1 for object, 0 for array
+    bool push(bool object)
+    {
+        if (depth >= max_depth) {
+            return false;
+        }
+        auto& word{levels[depth / 64]};
+        const auto bit{std::uint64_t{1} << (depth % 64)};
+        word = object ? (word | bit) : (word & ~bit);
+        ++depth;
+        return true;
+    }
+
+    bool in_object() const
+    {
+        const auto level{depth - 1};
+        return (levels[level / 64] >> (level % 64)) & 1;
+    }
+
+    validate_error scalar()
+    {
+        switch (*cur) {
+        case '"':
+            ++cur;
+            return string();
+        case 't':
+            return literal("true");
+        case 'f':
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default:
+            return number();
+        }
+    }
+
+    validate_error literal(std::string_view word)
+    {
+        const auto size{std::min(word.size(), static_cast<std::size_t>(end - cur))};
+        for (std::size_t i = 0; i < size; ++i, ++cur) {
+            if (*cur != word[i]) {
+                return validate_error::unexpected_char;
+            }
+        }
+        return size == word.size() ? validate_error::none : validate_error::unexpected_end;
+    }
+
+    validate_error number()
+    {
+        if (*cur == '-') {
+            ++cur;
+        }
+        if (cur == end) {
+            return validate_error::unexpected_end;
+        }
+        if (*cur == '0') {
+            ++cur;
+        } else if (*cur >= '1' && *cur <= '9') {
+            skip_digits();
+        } else {
+            return validate_error::invalid_number;
+        }
+        if (cur != end && *cur == '.') {
+            ++cur;
+            if (const auto error{digits()}; error != validate_error::none) {
+                return error;
+            }
+        }
+        if (cur != end && (*cur == 'e' || *cur == 'E')) {
+            ++cur;
+            if (cur != end && (*cur == '+' || *cur == '-')) {
+                ++cur;
+            }
+            return digits();
+        }
+        return validate_error::none;
+    }
+
+    // at least one digit
+    validate_error digits()
+    {
+        if (cur == end) {
+            return validate_error::unexpected_end;
+        }
+        if (!is_digit(*cur)) {
+            return validate_error::invalid_number;
+        }
+        skip_digits();
+        return validate_error::none;
+    }
+
+    void skip_digits()
+    {
+        while (cur != end && is_digit(*cur)) {
+            ++cur;
+        }
+    }
+
+    // we are after the opening quote
+    validate_error string()
+    {
+        while (true) {
+            // most of the chars in a string don't need any check
+            while (end - cur >= 8) {
+                std::uint64_t block;
+                std::memcpy(&block, cur, sizeof(block));
+                if (string_special(block)) {
+                    break;
+                }
+                cur += 8;
+            }
+            if (cur == end) {
+                return validate_error::unexpected_end;
+            }
+            const auto c{static_cast<unsigned char>(*cur)};
+            if (c == '"') {
+                ++cur;
+                return validate_error::none;
+            }
+            if (c == '\\') {
+                ++cur;
+                if (const auto error{escape()}; error != validate_error::none) {
+                    return error;
+                }
+            } else if (c < 0x20) {
+                return validate_error::invalid_string;
+            } else if (c < 0x80) {
+                ++cur;
+            } else if (!skip_sequence()) {
+                return validate_error::invalid_utf8;
+            }
+        }
+    }
+
+    // we are after the backslash
+    validate_error escape()
+    {
+        if (cur == end) {
+            return validate_error::unexpected_end;
+        }
+        switch (*cur) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            ++cur;
+            return validate_error::none;
+        case 'u':
+            ++cur;
+            return code_point_ref();
+        default:
+            return validate_error::invalid_escape;
+        }
+    }
+
+    // the same rules as json::read - a surrogate must be a pair of high and low
+    validate_error code_point_ref()
+    {
+        int code = 0;
+        if (const auto error{hex_quad(code)}; error != validate_error::none) {
+            return error;
+        }
+        if ((code & 0xfc00) == 0xdc00) {
+            return validate_error::invalid_escape;
+        }
+        if ((code & 0xfc00) == 0xd800) {
+            if (end - cur < 2) {
+                return validate_error::unexpected_end;
+            }
+            if (cur[0] != '\\' || cur[1] != 'u') {
+                return validate_error::invalid_escape;
+            }
+            cur += 2;
+            if (const auto error{hex_quad(code)}; error != validate_error::none) {
+                return error;
+            }
+            if ((code & 0xfc00) != 0xdc00) {
+                return validate_error::invalid_escape;
+            }
+        }
+        return validate_error::none;
+    }
+
+    validate_error hex_quad(int& code)
+    {
+        code = 0;
+        for (int i = 0; i < 4; ++i, ++cur) {
+            if (cur == end) {
+                return validate_error::unexpected_end;
+            }
+            const auto digit{hex_value(*cur)};
+            if (digit < 0) {
+                return validate_error::invalid_escape;
+            }
+            code = code * 16 + digit;
+        }
+        return validate_error::none;
+    }
+
+    // a multi byte UTF-8 sequence - without overlong forms,
+    // surrogates and values above 0x10ffff
+    bool skip_sequence()
+    {
+        const auto lead{static_cast<unsigned char>(*cur)};
+        int trailing = 0;
+        unsigned char low = 0x80;
+        unsigned char high = 0xbf;
+        if (lead >= 0xc2 && lead <= 0xdf) {
+            trailing = 1;
+        } else if (lead >= 0xe0 && lead <= 0xef) {
+            trailing = 2;
+            low = lead == 0xe0 ? 0xa0 : 0x80;
+            high = lead == 0xed ? 0x9f : 0xbf;
+        } else if (lead >= 0xf0 && lead <= 0xf4) {
+            trailing = 3;
+            low = lead == 0xf0 ? 0x90 : 0x80;
+            high = lead == 0xf4 ? 0x8f : 0xbf;
+        } else {
+            return false;
+        }
+        if (end - cur <= trailing) {
+            return false;
+        }
+        const auto first{static_cast<unsigned char>(cur[1])};
+        if (first < low || first > high) {
+            return false;
+        }
+        for (int i = 2; i <= trailing; ++i) {
+            if ((static_cast<unsigned char>(cur[i]) & 0xc0) != 0x80) {
+                return false;
+            }
+        }
+        cur += trailing + 1;
+        return true;
+    }
+
+    void skip_ws()
+    {
+        while (cur != end && (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r')) {
+            ++cur;
+        }
+    }
+
+    // the byte order mark at the start is allowed. Like the parser (and boost)
+    // we are not checking the rest of it, so we accept the same input
+    void skip_introduction()
+    {
+        if (cur != end && static_cast<unsigned char>(*cur) == 0xef) {
+            for (int i = 0; i < 3 && cur != end; ++i) {
+                ++cur;
+            }
+        }
+    }
+
+private:
+    const char* start = nullptr;
+    const char* cur = nullptr;
+    const char* end = nullptr;
+    std::size_t max_depth = 0;
+    std::size_t depth = 0;
+    std::array<std::uint64_t, validate_limits::max_supported_depth / 64> levels{};
+};
+
+}   // end of local namespace
+
+const char* describe(validate_error error)
+{
+    switch (error) {
+    case validate_error::none:
+        return "valid";
+    case validate_error::unexpected_end:
+        return "unexpected end of input";
+    case validate_error::unexpected_char:
+        return "unexpected char";
+    case validate_error::invalid_number:
+        return "invalid number";
+    case validate_error::invalid_string:
+        return "control char in string";
+    case validate_error::invalid_escape:
+        return "invalid escape";
+    case validate_error::invalid_utf8:
+        return "invalid UTF-8";
+    case validate_error::trailing_data:
+        return "data after the value";
+    case validate_error::too_deep:
+        return "too deep";
+    case validate_error::too_large:
+        return "too large";
+    }
+    return "unknown error";
+}
+
+validate_result validate(std::string_view input, const validate_limits& limits)
+{
+    if (limits.max_size > 0 && input.size() > limits.max_size) {
+        return validate_result{validate_error::too_large, limits.max_size};
+    }
+    return validator{input, limits}.run();
+}
+
+}   // end of namespace json
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Checking that the input is a valid JSON without reading it - nothing is
+// allocated and no tree is created, so this is much faster than json::read.
+// Use it when you only need to know if the message is valid, for example:
+//  const auto result{json::validate(message, json::validate_limits{.max_depth = 64})};
+//  if (!result) {
+//      std::cerr << json::describe(result.error) << " at " << result.offset << "\n";
+//  }
+// Any input that is valid here can be read with json::read and istream_root.
+// The other way is not always true - the UTF-8 is checked more strictly than
+// json::read does (overlong forms, surrogates and values above U+10FFFF are
+// rejected), and the limits are only checked here.
+namespace json
+{
+
+enum class validate_error : std::uint8_t
+{
+    none,
+    unexpected_end,     // the input ended in the middle of a value
+    unexpected_char,    // a char that cannot be at this location
+    invalid_number,
+    invalid_string,     // a control char in a string, it must be escaped
+    invalid_escape,
+    invalid_utf8,
+    trailing_data,      // there is something after the value
+    too_deep,           // more nested objects and arrays than max_depth
+    too_large           // the input is larger than max_size
+};
+
+const char* describe(validate_error error);
+
+struct validate_limits
+{
+    // the nesting is tracked without allocating memory, so it is limited
+    static constexpr std::size_t max_supported_depth = 4096;
+
+    std::size_t max_depth = max_supported_depth;    // larger values are the same as max_supported_depth
+    std::size_t max_size = 0;                       // in bytes, 0 for no limit
+};
+
+struct validate_result
+{
+    validate_error error = validate_error::none;
+    std::size_t offset = 0;     // the location of the error in the input
+
+    explicit operator bool () const
+    {
+        return error == validate_error::none;
+    }
+};
+
+validate_result validate(std::string_view input, const validate_limits& limits = validate_limits{});
+
+}   // end of namespace json
@@ -1,6 +1,8 @@
 #include "json_writer.h"
 #include "jsonfwrd.h"
 #include "json_istream.h"
+#include "json_emit.h"
+#include "json_timing.h"
 
 namespace json
 {
@@ -8,24 +10,52 @@ namespace json
 namespace
 {
 
-bool write_to(std::ostream& to, const boost::property_tree::ptree& pt, bool indent)
+template<typename Ch, typename Ptree>
+bool write_to(std::basic_ostream<Ch>& to, const Ptree& pt, bool indent)
 {
+    timing::scoped_timer timer{timing::phase::write};
     try {
-        write_json(to, pt, indent);
-        return true;
+        details::stream_sink<Ch> sink{to};
+        if (details::write_document(sink, pt, indent)) {
+            return to.good();
+        }
+        return false;
     } catch (const std::exception&) {
         return false;
     }
 }
 
-bool write_to(std::wostream& to, const boost::property_tree::wptree& pt, bool indent)
+template<typename Ptree>
+auto into_string(const Ptree& pt, bool indent) -> std::basic_string<typename Ptree::key_type::value_type>
 {
-    try {
-        write_json(to, pt, indent);
-        return true;
-    } catch (const std::exception&) {
-        return false;
+    timing::scoped_timer timer{timing::phase::write};
+    std::basic_string<typename Ptree::key_type::value_type> result;
+    details::write_into_string(result, pt, indent);
+    return result;
+}
+
+// note that we are only touching the output if we can write into it
+template<typename Ptree>
+std::size_t into_string(std::basic_string<typename Ptree::key_type::value_type>& to, const Ptree& pt, bool indent)
+{
+    timing::scoped_timer timer{timing::phase::write};
+    const auto size = details::document_size(pt, indent);
+    if (size > 0) {
+        to.resize(size);
+        details::write_into_buffer(to.data(), pt, indent);
     }
+    return size;
+}
+
+template<typename Ptree>
+std::size_t into_buffer(std::span<typename Ptree::key_type::value_type> to, const Ptree& pt, bool indent)
+{
+    timing::scoped_timer timer{timing::phase::write};
+    const auto size = details::document_size(pt, indent);
+    if (size == 0 || size > to.size()) {
+        return 0;
+    }
+    return details::write_into_buffer(to.data(), pt, indent);
 }
     
 }   // end of local namespace
@@ -223,97 +253,104 @@ const boost::property_tree::wptree& wgenerate_array::get_root() const
 
 bool write(std::ostream& to, generate_array& ga, bool indent)
 {
-    try {
-        write_json(to, ga.get_root(), indent);
-        return true;
-    } catch (const std::exception&) {
-        return false;
-    }
+    return write_to(to, ga.get_root(), indent);
 }
 
-
 bool write(std::ostream& to, array_writer& ga, bool indent)
 {
     return write_to(to, ga.get_nodes(), indent);
 }
 
+bool write(std::ostream& to, entry_writer& ga, bool indent)
+{
+    return write_to(to, ga.node(), indent);
+}
+
 std::string write(ostream& os, bool indent)
 {
-    std::ostringstream s;
-    if (write_to(s, os.entries(), indent)) {
-        return s.str();
-    } else {
-        const std::string error = std::string();
-        return error;
-    }
+    return into_string(os.entries(), indent);
 }
 
-bool write(std::ostream& to, entry_writer& ga, bool indent)
+std::string write(generate_array& ga, bool indent)
 {
-    try {
-        write_json(to, ga.node(), indent);
-        return true;
-    } catch (const std::exception&) {        
-        return false;
-    }
+    return into_string(ga.get_root(), indent);
+}
+
+std::string write(array_writer& ga, bool indent)
+{
+    return into_string(ga.get_nodes(), indent);
 }
 
+std::string write(entry_writer& ga, bool indent)
+{
+    return into_string(ga.node(), indent);
+}
 
-std::string write(generate_array& ga, bool indent)
+std::size_t write(generate_array& ga, std::string& arg, bool indent)
 {
-    std::ostringstream target;
-    if (json::write(target, ga, indent)) {
-        return target.str();
-    } else {
-        static const std::string err = std::string();
-        return err;
-    }
+    return into_string(arg, ga.get_root(), indent);
 }
 
-void write(generate_array& ga, std::string& arg, bool indent)
+std::size_t write(entry_writer& ga, std::string& to, bool indent)
 {
-	std::ostringstream target;
-    if (json::write(target, ga, indent))
-        arg.assign(target.str());
+    return into_string(to, ga.node(), indent);
 }
 
+std::size_t write(array_writer& ga, std::string& to, bool indent)
+{
+    return into_string(to, ga.get_nodes(), indent);
+}
 
-std::string write(array_writer& ga, bool indent)
+std::size_t write(ostream& os, std::string& to, bool indent)
 {
-    std::ostringstream target;
-    if (json::write(target, ga, indent)) {
-        return target.str();
-    } else {
-        static const std::string err = std::string();
-        return err;
-    }
+    return into_string(to, os.entries(), indent);
 }
 
+std::size_t write(entry_writer& ga, std::span<char> to, bool indent)
+{
+    return into_buffer(to, ga.node(), indent);
+}
 
-std::string write(entry_writer& ga, bool indent)
+std::size_t write(array_writer& ga, std::span<char> to, bool indent)
 {
-    std::ostringstream target;
-    if (json::write(target, ga, indent)) {
-        return target.str();
-    } else {
-        static const std::string err = std::string();
-        return err;
-    }
+    return into_buffer(to, ga.get_nodes(), indent);
 }
 
-///////////////////////////////////////////////////////////////////////////////
+std::size_t write(generate_array& ga, std::span<char> to, bool indent)
+{
+    return into_buffer(to, ga.get_root(), indent);
+}
+
+std::size_t write(ostream& os, std::span<char> to, bool indent)
+{
+    return into_buffer(to, os.entries(), indent);
+}
+
+std::size_t output_size(entry_writer& ga, bool indent)
+{
+    return details::document_size(ga.node(), indent);
+}
+
+std::size_t output_size(array_writer& ga, bool indent)
+{
+    return details::document_size(ga.get_nodes(), indent);
+}
+
+std::size_t output_size(generate_array& ga, bool indent)
+{
+    return details::document_size(ga.get_root(), indent);
+}
+
+std::size_t output_size(ostream& os, bool indent)
+{
+    return details::document_size(os.entries(), indent);
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 
 std::wstring wwrite(wostream& os, bool indent)
 {
-    std::wostringstream s;
-    if (write_to(s, os.entries(), indent)) {
-        return s.str();
-    } else {
-        static const std::wstring error = std::wstring();
-        return error;
-    }
+    return into_string(os.entries(), indent);
 }
 
 bool wwrite(std::wostream& to, wgenerate_array& ga, bool indent)
@@ -321,89 +358,105 @@ bool wwrite(std::wostream& to, wgenerate_array& ga, bool indent)
     return write_to(to, ga.get_root(), indent);
 }
 
-
 bool wwrite(std::wostream& to, warray_writer& ga, bool indent)
 {
-    try {
-        write_json(to, ga.get_nodes(), indent);
-        return true;
-    } catch (const std::exception&) {
-        return false;
-    }
+    return write_to(to, ga.get_nodes(), indent);
 }
 
-
 bool wwrite(std::wostream& to, wentry_writer& ga, bool indent)
 {
-    try {
-        write_json(to, ga.node(), indent);
-        return true;
-    } catch (const std::exception&) {        
-        return false;
-    }
+    return write_to(to, ga.node(), indent);
 }
 
-
 std::wstring wwrite(wgenerate_array& ga, bool indent)
 {
-    std::wostringstream target;
-    if (json::wwrite(target, ga, indent)) {
-        return target.str();
-    } else {
-        static const std::wstring err = std::wstring();
-        return err;
-    }
+    return into_string(ga.get_root(), indent);
 }
 
-
 std::wstring wwrite(warray_writer& ga, bool indent)
 {
-    std::wostringstream target;
-    if (json::wwrite(target, ga, indent)) {
-        return target.str();
-    } else {
-        static const std::wstring err = std::wstring();
-        return err;
-    }
+    return into_string(ga.get_nodes(), indent);
 }
 
-
 std::wstring wwrite(wentry_writer& ga, bool indent)
 { 
-    std::wostringstream target;
-    if (json::wwrite(target, ga, indent)) {
-        return target.str();
-    } else {
-        static const std::wstring err = std::wstring();
-        return err;
-    }
+    return into_string(ga.node(), indent);
+}
+
+std::size_t wwrite(wentry_writer& ga, std::wstring& to, bool indent)
+{
+    return into_string(to, ga.node(), indent);
 }
 
+std::size_t wwrite(warray_writer& ga, std::wstring& to, bool indent)
+{
+    return into_string(to, ga.get_nodes(), indent);
+}
+
+std::size_t wwrite(wgenerate_array& ga, std::wstring& to, bool indent)
+{
+    return into_string(to, ga.get_root(), indent);
+}
+
+std::size_t wwrite(wostream& os, std::wstring& to, bool indent)
+{
+    return into_string(to, os.entries(), indent);
+}
+
+std::size_t wwrite(wentry_writer& ga, std::span<wchar_t> to, bool indent)
+{
+    return into_buffer(to, ga.node(), indent);
+}
+
+std::size_t wwrite(warray_writer& ga, std::span<wchar_t> to, bool indent)
+{
+    return into_buffer(to, ga.get_nodes(), indent);
+}
+
+std::size_t wwrite(wgenerate_array& ga, std::span<wchar_t> to, bool indent)
+{
+    return into_buffer(to, ga.get_root(), indent);
+}
+
+std::size_t wwrite(wostream& os, std::span<wchar_t> to, bool indent)
+{
+    return into_buffer(to, os.entries(), indent);
+}
+
+std::size_t output_size(wentry_writer& ga, bool indent)
+{
+    return details::document_size(ga.node(), indent);
+}
+
+std::size_t output_size(warray_writer& ga, bool indent)
+{
+    return details::document_size(ga.get_nodes(), indent);
+}
+
+std::size_t output_size(wgenerate_array& ga, bool indent)
+{
+    return details::document_size(ga.get_root(), indent);
+}
+
+std::size_t output_size(wostream& os, bool indent)
+{
+    return details::document_size(os.entries(), indent);
+}
 
 std::string as_string(const istream& input)
 {
-    std::ostringstream buffer;
-    if (json::write_to(buffer, input.entries(), false)) {
-        return buffer.str();
-    } else {
-        static const std::string error = std::string();
-        return error;
-    }
+    return into_string(input.entries(), false);
 }
 
 namespace detail
 {
 
 std::string impl2string<char>::write(basic_output_stream<char>& input) {
-    std::ostringstream s;
-    write_to(s, input.tree_root, false);
-    return s.str();
+    return into_string(input.tree_root, false);
 }
 
 std::wstring impl2string<wchar_t>::write(basic_output_stream<wchar_t>& input) {
-    std::wostringstream s;
-    write_to(s, input.tree_root, false);
-    return s.str();
+    return into_string(input.tree_root, false);
 }
 
 }   // end of namespace detail
@@ -1,9 +1,11 @@
 #pragma once
 #include "json_base.h"
+#include "json_format.h"
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <iostream>
 #include <sstream>
+#include <string_view>
 #include <utility>      // std::pair
 #include <boost/mpl/if.hpp> // boost::mpl::if_c
 #include <boost/type_traits/is_pointer.hpp> // boost::is_pointer
@@ -327,6 +329,42 @@ struct writer_setup
                             >::type   type;
 };
 
+// write the array of numbers directly into the result, this is the
+// same as building the tree with the base name as the path to the array
+// and then write it, only that we don't create any node along the way
+template<typename Ch, typename Iter>
+std::basic_string<Ch> write_numbers_array(const char* base, Iter from, Iter to)
+{
+    using string_type = std::basic_string<Ch>;
+
+    string_type result;
+    const std::string_view path{base};
+    std::size_t depth = 0;
+    std::size_t start = 0;
+    while (start <= path.size()) {
+        auto end = path.find('.', start);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        const std::string key{path.substr(start, end - start)};
+        result += Ch('{');
+        result += Ch('"');
+        if constexpr (std::is_same_v<Ch, char>) {
+            result += boost::property_tree::json_parser::create_escapes(key);
+        } else {
+            result += boost::property_tree::json_parser::create_escapes(widen_str(key));
+        }
+        result += Ch('"');
+        result += Ch(':');
+        ++depth;
+        start = end + 1;
+    }
+    append_array(result, from, to);
+    result.append(depth, Ch('}'));
+    result += Ch('\n');
+    return result;
+}
+
 template<typename IterSetup, bool WC>
 struct iteration_writing
 {
@@ -338,6 +376,16 @@ struct iteration_writing
     typedef typename iter_setup::value_type     value_type;
 
     static result_type run(const char* base, iterator_type from, iterator_type to)
+    {
+        if constexpr (is_native_number_v<value_type>) {
+            return write_numbers_array<typename result_type::value_type>(base, from, to);
+        } else {
+            return run_nodes(base, from, to);
+        }
+    }
+
+private:
+    static result_type run_nodes(const char* base, iterator_type from, iterator_type to)
     {
         typedef typename charset_setup::entry_type entry_type;
         typedef typename charset_setup::generate_type generate_type;
@@ -396,7 +444,7 @@ std::string write_array(const char* base, Iter from, Iter to)
 }
 
 template<typename Iter>
-std::string wwrite_array(const char* base, Iter from, Iter to)
+std::wstring wwrite_array(const char* base, Iter from, Iter to)
 {
     typedef typename boost::mpl::if_c<boost::is_pointer<Iter>::value,
                                       details::pointer_writer<Iter, true>,
@@ -5,6 +5,7 @@
 #include "json_istream.h"
 
 #include <iosfwd>
+#include <span>
 #include <string>
 
 namespace json
@@ -14,7 +15,7 @@ std::string write(entry_writer& ga, bool indent = false);
 std::string write(array_writer& ga, bool indent = false);
 std::string write(generate_array& ga, bool indent = false);
 std::string write(ostream& os, bool indent = false);
-void write(generate_array& ga, std::string& arg, bool indent = false);
+std::size_t write(generate_array& ga, std::string& arg, bool indent = false);
 // wide char version
 std::wstring wwrite(wentry_writer& ga, bool indent = false);
 std::wstring wwrite(warray_writer& ga, bool indent = false);
@@ -31,6 +32,38 @@ bool wwrite(std::wostream& to, wentry_writer& ga, bool indent = false);
 bool wwrite(std::wostream& to, warray_writer& ga, bool indent = false);
 bool wwrite(std::wostream& to, wgenerate_array& ga, bool indent = false);
 
+// exact size output - the size of the output is calculated first and then the
+// output is written in a single pass, into a string that is allocated once,
+// or into a user supplied buffer. These return the number of chars written.
+// Zero is returned on error, or when the given buffer is too small - in this
+// case nothing is written (use output_size to find the size required)
+std::size_t output_size(entry_writer& ga, bool indent = false);
+std::size_t output_size(array_writer& ga, bool indent = false);
+std::size_t output_size(generate_array& ga, bool indent = false);
+std::size_t output_size(ostream& os, bool indent = false);
+std::size_t write(entry_writer& ga, std::string& to, bool indent = false);
+std::size_t write(array_writer& ga, std::string& to, bool indent = false);
+std::size_t write(ostream& os, std::string& to, bool indent = false);
+std::size_t write(entry_writer& ga, std::span<char> to, bool indent = false);
+std::size_t write(array_writer& ga, std::span<char> to, bool indent = false);
+std::size_t write(generate_array& ga, std::span<char> to, bool indent = false);
+std::size_t write(ostream& os, std::span<char> to, bool indent = false);
+
+// wide char version
+std::size_t output_size(wentry_writer& ga, bool indent = false);
+std::size_t output_size(warray_writer& ga, bool indent = false);
+std::size_t output_size(wgenerate_array& ga, bool indent = false);
+std::size_t output_size(wostream& os, bool indent = false);
+std::size_t wwrite(wentry_writer& ga, std::wstring& to, bool indent = false);
+std::size_t wwrite(warray_writer& ga, std::wstring& to, bool indent = false);
+std::size_t wwrite(wgenerate_array& ga, std::wstring& to, bool indent = false);
+std::size_t wwrite(wostream& os, std::wstring& to, bool indent = false);
+std::size_t wwrite(wentry_writer& ga, std::span<wchar_t> to, bool indent = false);
+std::size_t wwrite(warray_writer& ga, std::span<wchar_t> to, bool indent = false);
+std::size_t wwrite(wgenerate_array& ga, std::span<wchar_t> to, bool indent = false);
+std::size_t wwrite(wostream& os, std::span<wchar_t> to, bool indent = false);
+
+// to get the text as it is in the input, without writing it again, use json::raw_view
 std::string as_string(const json::istream& from);  // return the entries under the given istream objs as plain string
 
 }   // namespace json
@@ -4,4 +4,12 @@
 #include "impl/json_ostream.h"
 #include "impl/json_writer.h"
 #include "impl/jsonfwrd.h"
-#include "impl/json_utils.h"
\ No newline at end of file
+#include "impl/json_utils.h"
+#include "impl/json_sink.h"
+#include "impl/json_chunked_writer.h"
+#include "impl/json_ndjson.h"
+#include "impl/json_alloc_stats.h"
+#include "impl/json_timing.h"
+#include "impl/json_validate.h"
+#include "impl/json_projection.h"
+#include "impl/json_array_stream.h"